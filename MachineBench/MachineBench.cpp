@@ -0,0 +1,416 @@
+/**
+ * @file MachineBench.cpp
+ * @author djmik
+ *
+ * Benchmarks of the machine library hot paths
+ *
+ * Run with --benchmark_out=results.json --benchmark_out_format=json
+ * to record results for comparison across commits.
+ */
+
+#include "pch.h"
+#include <wx/init.h>
+#include <wx/filename.h>
+#include <benchmark/benchmark.h>
+#include <b2_world.h>
+#include <b2_body.h>
+#include <b2_fixture.h>
+#include <b2_polygon_shape.h>
+#include <b2_circle_shape.h>
+#include <fstream>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+#include "Machine.h"
+#include "MachineSystem.h"
+#include "Machine1Factory.h"
+#include "Machine2Factory.h"
+#include "StressFactory.h"
+#include "MachineDescription.h"
+#include "MachineBinary.h"
+#include "DominoFactory.h"
+#include "ContactListener.h"
+
+/// Frame rate the machines are run at
+const double FrameRate = 30;
+
+/// Size of the offscreen image machines are drawn into
+const wxSize DrawSize = wxSize(1200, 800);
+
+/**
+ * Create one of the machines built into the code
+ * @param number Machine number, 1 or 2
+ * @return Machine
+ */
+static std::shared_ptr<Machine> CreateMachine(int number)
+{
+    return number == 1 ? Machine1Factory::Create(MACHINE_RESOURCES_DIR) :
+           Machine2Factory::Create(MACHINE_RESOURCES_DIR);
+}
+
+/**
+ * Create a machine system showing a machine
+ * @param number Machine number
+ * @return Machine system, built synchronously
+ */
+static std::shared_ptr<MachineSystem> CreateSystem(int number)
+{
+    auto system = std::make_shared<MachineSystem>(MACHINE_RESOURCES_DIR);
+    system->SetAsynchronous(false);
+    system->SetFrameRate(FrameRate);
+    system->SetMachineNumber(number);
+    return system;
+}
+
+/**
+ * Machine::Update throughput, one frame per iteration
+ * @param state Benchmark state, range 0 is the machine number
+ */
+static void BM_Update(benchmark::State& state)
+{
+    auto machine = CreateMachine(state.range(0));
+
+    int frames = 0;
+    for (auto _ : state)
+    {
+        machine->Update(1.0 / FrameRate);
+
+        // Keep the machine in the part of its run that has motion
+        if (++frames == 600)
+        {
+            state.PauseTiming();
+            machine->Reset();
+            frames = 0;
+            state.ResumeTiming();
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Update)->Arg(1)->Arg(2);
+
+/**
+ * Seek forward from the start to a frame
+ * @param state Benchmark state, range 0 is the machine number
+ * and range 1 the frame to seek to
+ */
+static void BM_SeekForward(benchmark::State& state)
+{
+    auto system = CreateSystem(state.range(0));
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        system->SetMachineFrame(0);
+        state.ResumeTiming();
+
+        system->SetMachineFrame(state.range(1));
+    }
+}
+BENCHMARK(BM_SeekForward)->Args({1, 300})->Args({2, 300})->Unit(benchmark::kMillisecond);
+
+/**
+ * Seek backward to an earlier frame, which replays from the start
+ * @param state Benchmark state, range 0 is the machine number
+ * and range 1 the frame to seek to
+ */
+static void BM_SeekBackward(benchmark::State& state)
+{
+    auto system = CreateSystem(state.range(0));
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        system->SetMachineFrame(state.range(1) * 2);
+        state.ResumeTiming();
+
+        system->SetMachineFrame(state.range(1));
+    }
+}
+BENCHMARK(BM_SeekBackward)->Args({1, 150})->Args({2, 150})->Unit(benchmark::kMillisecond);
+
+/**
+ * Machine::Reset after running for a while
+ * @param state Benchmark state, range 0 is the machine number
+ */
+static void BM_Reset(benchmark::State& state)
+{
+    auto machine = CreateMachine(state.range(0));
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        for (int i = 0; i < 60; i++)
+        {
+            machine->Update(1.0 / FrameRate);
+        }
+        state.ResumeTiming();
+
+        machine->Reset();
+    }
+}
+BENCHMARK(BM_Reset)->Arg(1)->Arg(2);
+
+/**
+ * Factory construction time with images already cached
+ * @param state Benchmark state, range 0 is the machine number
+ */
+static void BM_Create(benchmark::State& state)
+{
+    // The first machine decodes the images
+    CreateMachine(state.range(0));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(CreateMachine(state.range(0)));
+    }
+}
+BENCHMARK(BM_Create)->Arg(1)->Arg(2)->Unit(benchmark::kMillisecond);
+
+/**
+ * Listener that counts the contacts dispatched to it
+ */
+class CountingListener : public b2ContactListener
+{
+public:
+    /// Contacts begun
+    int mBegin = 0;
+
+    /**
+     * Count a contact beginning
+     * @param contact Contact object
+     */
+    void BeginContact(b2Contact* contact) override { mBegin++; }
+
+    /**
+     * Count a contact about to be solved
+     * @param contact Contact object
+     * @param oldManifold Manifold object
+     */
+    void PreSolve(b2Contact* contact, const b2Manifold* oldManifold) override { benchmark::DoNotOptimize(contact); }
+};
+
+/**
+ * ContactListener dispatch while a pile of balls settles onto
+ * bodies that each have a listener
+ * @param state Benchmark state, range 0 is the number of balls
+ */
+static void BM_ContactDispatch(benchmark::State& state)
+{
+    b2World world(b2Vec2(0, -9.8f));
+    ContactListener listener;
+    CountingListener counter;
+    world.SetContactListener(&listener);
+
+    // A row of static blocks, each dispatching its contacts
+    for (int i = 0; i < 20; i++)
+    {
+        b2BodyDef def;
+        def.position.Set(i * 0.5f, 0);
+        auto body = world.CreateBody(&def);
+
+        b2PolygonShape box;
+        box.SetAsBox(0.25f, 0.1f);
+        body->CreateFixture(&box, 0);
+        listener.Add(body, &counter);
+    }
+
+    for (int i = 0; i < state.range(0); i++)
+    {
+        b2BodyDef def;
+        def.type = b2_dynamicBody;
+        def.position.Set((i % 20) * 0.5f, 0.5f + (i / 20) * 0.3f);
+        auto body = world.CreateBody(&def);
+
+        b2CircleShape circle;
+        circle.m_radius = 0.1f;
+        body->CreateFixture(&circle, 1);
+    }
+
+    for (auto _ : state)
+    {
+        world.Step(1.0f / FrameRate, 6, 2);
+    }
+
+    state.counters["contacts"] = benchmark::Counter(counter.mBegin, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_ContactDispatch)->Arg(100)->Arg(1000);
+
+/**
+ * MachineSystem::DrawMachine into an offscreen image
+ * @param state Benchmark state, range 0 is the machine number
+ */
+static void BM_Draw(benchmark::State& state)
+{
+    auto system = CreateSystem(state.range(0));
+    system->SetLocation(wxPoint(DrawSize.GetWidth() / 2, DrawSize.GetHeight() - 50));
+    system->SetQuality(MachineSystem::Quality::Best);
+    system->SetMachineFrame(120);
+
+    wxImage image(DrawSize);
+    std::shared_ptr<wxGraphicsContext> graphics(wxGraphicsContext::Create(image));
+
+    // The first draw creates the bitmaps
+    system->DrawMachine(graphics);
+
+    for (auto _ : state)
+    {
+        system->DrawMachine(graphics);
+        graphics->Flush();
+    }
+}
+BENCHMARK(BM_Draw)->Arg(1)->Arg(2)->Unit(benchmark::kMicrosecond);
+
+/**
+ * Time to load a compiled machine and install it into a b2World
+ *
+ * The machine is a grid of dynamic domino sized bodies sharing one
+ * image, compiled to a temporary file before timing starts.
+ * @param state Benchmark state, range 0 is the number of bodies
+ */
+static void BM_BinaryLoad(benchmark::State& state)
+{
+    MachineDescription description;
+    int image = description.AddAsset(L"domino-red.png");
+
+    const int columns = 200;
+    for (int i = 0; i < state.range(0); i++)
+    {
+        MachineDescription::Element element;
+        element.shape = MachineDescription::Shape::Rectangle;
+        element.motion = MachineDescription::Motion::Dynamic;
+        element.image = image;
+        element.position = wxPoint2DDouble((i % columns) * DominoFactory::DominoWidth * 3,
+                                           (i / columns) * DominoFactory::DominoHeight * 1.5);
+        element.rectangle = wxRect2DDouble(0, 0,
+                                           DominoFactory::DominoWidth, DominoFactory::DominoHeight);
+        description.AddElement(element);
+    }
+
+    MachineBinary binary;
+    auto filename = wxFileName::CreateTempFileName(L"machine").ToStdWstring();
+    if (!binary.Save(description, filename))
+    {
+        state.SkipWithError("Unable to write compiled machine");
+        return;
+    }
+
+    // The first load decodes the image
+    binary.Load(filename, MACHINE_RESOURCES_DIR);
+
+    double read = 0, build = 0;
+    for (auto _ : state)
+    {
+        auto machine = binary.Load(filename, MACHINE_RESOURCES_DIR);
+        machine->Reset();
+        benchmark::DoNotOptimize(machine);
+
+        read += binary.GetReadTime();
+        build += binary.GetBuildTime();
+    }
+
+    wxRemoveFile(filename);
+
+    state.counters["read ms"] = benchmark::Counter(read, benchmark::Counter::kAvgIterations);
+    state.counters["build ms"] = benchmark::Counter(build, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_BinaryLoad)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+/**
+ * Get the memory the process is using
+ * @return Resident size in bytes, 0 where it cannot be measured
+ */
+static size_t ResidentMemory()
+{
+#ifdef __linux__
+    // Second field is resident pages
+    std::ifstream statm("/proc/self/statm");
+    size_t total = 0, resident = 0;
+    statm >> total >> resident;
+    return resident * sysconf(_SC_PAGESIZE);
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Step time of stress machines as they grow
+ * @param state Benchmark state, range 0 is the number of bodies
+ */
+static void BM_StressUpdate(benchmark::State& state)
+{
+    auto parameters = StressFactory::ForBodies(state.range(0));
+
+    auto memory = ResidentMemory();
+    auto machine = StressFactory::Create(MACHINE_RESOURCES_DIR, parameters);
+    memory = ResidentMemory() - memory;
+
+    int frames = 0;
+    for (auto _ : state)
+    {
+        machine->Update(1.0 / FrameRate);
+
+        if (++frames == 300)
+        {
+            state.PauseTiming();
+            machine->Reset();
+            frames = 0;
+            state.ResumeTiming();
+        }
+    }
+
+    state.counters["bodies"] = StressFactory::BodyCount(parameters);
+    state.counters["memory"] = benchmark::Counter(memory, benchmark::Counter::kDefaults, benchmark::Counter::kIs1024);
+}
+BENCHMARK(BM_StressUpdate)->RangeMultiplier(10)->Range(100, 100000)->Unit(benchmark::kMillisecond);
+
+/**
+ * Draw time of stress machines as they grow
+ * @param state Benchmark state, range 0 is the number of bodies
+ */
+static void BM_StressDraw(benchmark::State& state)
+{
+    auto system = CreateSystem(state.range(0));
+    system->SetLocation(wxPoint(DrawSize.GetWidth() / 2, DrawSize.GetHeight() - 50));
+    system->SetQuality(MachineSystem::Quality::Best);
+    system->SetMachineFrame(30);
+
+    wxImage image(DrawSize);
+    std::shared_ptr<wxGraphicsContext> graphics(wxGraphicsContext::Create(image));
+    system->DrawMachine(graphics);
+
+    for (auto _ : state)
+    {
+        system->DrawMachine(graphics);
+        graphics->Flush();
+    }
+
+    state.counters["bodies"] = StressFactory::BodyCount(StressFactory::ForBodies(state.range(0)));
+}
+BENCHMARK(BM_StressDraw)->RangeMultiplier(10)->Range(100, 100000)->Unit(benchmark::kMillisecond);
+
+/**
+ * Run the benchmarks
+ * @param argc Argument count
+ * @param argv Arguments, passed to Google Benchmark
+ * @return 0 if successful
+ */
+int main(int argc, char** argv)
+{
+    wxInitializer initializer;
+    if (!initializer.IsOk())
+    {
+        return 1;
+    }
+
+    wxInitAllImageHandlers();
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    {
+        return 1;
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
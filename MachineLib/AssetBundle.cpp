@@ -0,0 +1,346 @@
+/**
+ * @file AssetBundle.cpp
+ * @author djmik
+ */
+
+#include "pch.h"
+#include <wx/dir.h>
+#include <wx/file.h>
+#include <wx/mstream.h>
+#include <algorithm>
+#include "AssetBundle.h"
+#include "BinaryStream.h"
+
+#ifdef WIN32
+#include <wx/msw/wrapwin.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/// Identifies an asset bundle file
+const char BundleMagic[4] = {'I', 'M', 'A', 'B'};
+
+/// Version of the bundle format. Files from other versions are rejected.
+const uint32_t BundleVersion = 1;
+
+/// Image data is aligned to this many bytes within the file
+const size_t BundleAlignment = 16;
+
+/**
+ * Destructor
+ */
+AssetBundle::~AssetBundle()
+{
+    Close();
+}
+
+/**
+ * Unmap any open bundle
+ */
+void AssetBundle::Close()
+{
+    if (mData != nullptr)
+    {
+#ifdef WIN32
+        UnmapViewOfFile(mData);
+        CloseHandle(mMapping);
+        mMapping = nullptr;
+#else
+        munmap(const_cast<char*>(mData), mSize);
+#endif
+    }
+
+    mData = nullptr;
+    mSize = 0;
+    mEntries.clear();
+}
+
+/**
+ * Open a bundle file
+ *
+ * Only the index is read. Image data is read from the mapping as
+ * images are decoded.
+ * @param filename Bundle file
+ * @return true if successful
+ */
+bool AssetBundle::Open(const std::wstring &filename)
+{
+    Close();
+    mError.clear();
+
+#ifdef WIN32
+    auto file = CreateFileW(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        mError = L"Unable to open asset bundle '" + filename + L"'";
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    GetFileSizeEx(file, &size);
+    mMapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mMapping == nullptr)
+    {
+        mError = L"Unable to map asset bundle '" + filename + L"'";
+        return false;
+    }
+
+    mData = static_cast<const char*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+    if (mData == nullptr)
+    {
+        CloseHandle(mMapping);
+        mMapping = nullptr;
+        mError = L"Unable to map asset bundle '" + filename + L"'";
+        return false;
+    }
+
+    mSize = (size_t)size.QuadPart;
+#else
+    int file = open(wxString(filename).fn_str(), O_RDONLY);
+    if (file < 0)
+    {
+        mError = L"Unable to open asset bundle '" + filename + L"'";
+        return false;
+    }
+
+    struct stat info;
+    void* data = MAP_FAILED;
+    if (fstat(file, &info) == 0 && info.st_size > 0)
+    {
+        data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    }
+
+    // The mapping stays valid after the file is closed
+    close(file);
+    if (data == MAP_FAILED)
+    {
+        mError = L"Unable to map asset bundle '" + filename + L"'";
+        return false;
+    }
+
+    mData = static_cast<const char*>(data);
+    mSize = info.st_size;
+#endif
+
+    BinaryReader reader(mData, mSize);
+    for (auto c : BundleMagic)
+    {
+        if (reader.Read<char>() != c)
+        {
+            Close();
+            mError = L"'" + filename + L"' is not an asset bundle";
+            return false;
+        }
+    }
+
+    if (reader.Read<uint32_t>() != BundleVersion)
+    {
+        Close();
+        mError = L"'" + filename + L"' was built for a different version";
+        return false;
+    }
+
+    auto count = reader.Read<uint32_t>();
+    for (uint32_t i = 0; i < count && !reader.IsOverrun(); i++)
+    {
+        auto name = reader.ReadString();
+
+        Entry entry;
+        entry.format = (Format)reader.Read<uint32_t>();
+        entry.width = reader.Read<int32_t>();
+        entry.height = reader.Read<int32_t>();
+        entry.offset = reader.Read<uint64_t>();
+        entry.size = reader.Read<uint64_t>();
+        mEntries[name] = entry;
+    }
+
+    bool valid = !reader.IsOverrun();
+    for (const auto& entry : mEntries)
+    {
+        valid = valid && entry.second.offset + entry.second.size <= mSize;
+    }
+
+    if (!valid)
+    {
+        Close();
+        mError = L"Asset bundle '" + filename + L"' is truncated";
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Build a bundle from every image in a directory
+ * @param imagesDir Directory holding the images
+ * @param filename Bundle file to write
+ * @param format Whether images are stored encoded or decoded
+ * @return true if successful
+ */
+bool AssetBundle::Save(const std::wstring &imagesDir, const std::wstring &filename, Format format)
+{
+    // Prevent error popup from wxWidgets
+    wxLogNull logNo;
+    mError.clear();
+
+    wxDir dir(imagesDir);
+    if (!dir.IsOpened())
+    {
+        mError = L"Unable to open image directory '" + imagesDir + L"'";
+        return false;
+    }
+
+    // Sorted so the same directory always produces the same file
+    std::vector<std::wstring> names;
+    wxString file;
+    for (bool found = dir.GetFirst(&file, wxEmptyString, wxDIR_FILES); found; found = dir.GetNext(&file))
+    {
+        names.push_back(file.ToStdWstring());
+    }
+    std::sort(names.begin(), names.end());
+
+    std::vector<std::wstring> stored;
+    std::vector<Entry> entries;
+    std::vector<std::vector<char>> blobs;
+    for (const auto& name : names)
+    {
+        auto path = imagesDir + L"/" + name;
+
+        wxImage image;
+        if (!image.LoadFile(path, wxBITMAP_TYPE_ANY))
+        {
+            // Not an image
+            continue;
+        }
+
+        Entry entry;
+        entry.format = format;
+        std::vector<char> blob;
+        if (format == Format::Raw)
+        {
+            if (!image.HasAlpha())
+            {
+                image.InitAlpha();
+            }
+
+            // RGB plane followed by the alpha plane, as wxImage holds them
+            size_t pixels = (size_t)image.GetWidth() * image.GetHeight();
+            blob.resize(pixels * 4);
+            std::memcpy(blob.data(), image.GetData(), pixels * 3);
+            std::memcpy(blob.data() + pixels * 3, image.GetAlpha(), pixels);
+            entry.width = image.GetWidth();
+            entry.height = image.GetHeight();
+        }
+        else
+        {
+            wxFile source(path);
+            blob.resize(source.Length());
+            if (!source.IsOpened() || source.Read(blob.data(), blob.size()) != (ssize_t)blob.size())
+            {
+                mError = L"Unable to read image '" + path + L"'";
+                return false;
+            }
+        }
+
+        entry.size = blob.size();
+        stored.push_back(name);
+        entries.push_back(entry);
+        blobs.push_back(std::move(blob));
+    }
+
+    // Offsets depend on the size of the index, so lay out the index
+    // once to measure it and then again with the real offsets
+    BinaryWriter writer;
+    for (int pass = 0; pass < 2; pass++)
+    {
+        size_t offset = writer.GetBuffer().size();
+
+        writer = BinaryWriter();
+        for (auto c : BundleMagic)
+        {
+            writer.Write(c);
+        }
+
+        writer.Write(BundleVersion);
+        writer.Write<uint32_t>(entries.size());
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            offset = (offset + BundleAlignment - 1) / BundleAlignment * BundleAlignment;
+            entries[i].offset = offset;
+            offset += entries[i].size;
+
+            writer.WriteString(stored[i]);
+            writer.Write<uint32_t>((uint32_t)entries[i].format);
+            writer.Write<int32_t>(entries[i].width);
+            writer.Write<int32_t>(entries[i].height);
+            writer.Write<uint64_t>(entries[i].offset);
+            writer.Write<uint64_t>(entries[i].size);
+        }
+    }
+
+    for (size_t i = 0; i < blobs.size(); i++)
+    {
+        writer.Align(BundleAlignment);
+        writer.WriteBytes(blobs[i].data(), blobs[i].size());
+    }
+
+    wxFile output;
+    auto& buffer = writer.GetBuffer();
+    if (!output.Create(filename, true) || output.Write(buffer.data(), buffer.size()) != buffer.size())
+    {
+        mError = L"Unable to write asset bundle '" + filename + L"'";
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Decode an image from the bundle
+ *
+ * This only touches the pages of the file holding this image.
+ * @param name Image file name relative to the images directory
+ * @return Decoded image, or nullptr if the bundle does not contain it
+ */
+std::shared_ptr<wxImage> AssetBundle::Decode(const std::wstring &name) const
+{
+    auto found = mEntries.find(name);
+    if (found == mEntries.end())
+    {
+        return nullptr;
+    }
+
+    auto& entry = found->second;
+    auto data = mData + entry.offset;
+    auto image = std::make_shared<wxImage>();
+
+    if (entry.format == Format::Raw)
+    {
+        size_t pixels = (size_t)entry.width * entry.height;
+        if (pixels * 4 != entry.size || !image->Create(entry.width, entry.height, false))
+        {
+            return nullptr;
+        }
+
+        std::memcpy(image->GetData(), data, pixels * 3);
+        image->SetAlpha();
+        std::memcpy(image->GetAlpha(), data + pixels * 3, pixels);
+        return image;
+    }
+
+    // Prevent error popup from wxWidgets
+    wxLogNull logNo;
+
+    wxMemoryInputStream stream(data, entry.size);
+    if (!image->LoadFile(stream, wxBITMAP_TYPE_ANY))
+    {
+        return nullptr;
+    }
+
+    return image;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file AssetBundle.h
+ * @author djmik
+ *
+ * Single file holding every image, read through a memory mapping
+ */
+
+#ifndef CANADIANEXPERIENCE_MACHINELIB_ASSETBUNDLE_H
+#define CANADIANEXPERIENCE_MACHINELIB_ASSETBUNDLE_H
+
+#include <map>
+
+/**
+ * Asset bundle class
+ *
+ * A bundle is an index followed by the data of every image in a
+ * directory. Images are stored either as their original encoded file
+ * or already decoded in the layout wxImage uses, which only needs to
+ * be copied. The bundle is memory mapped, so only the images actually
+ * used are paged in from disk.
+ *
+ * Bundles are built by the AssetBundler tool.
+ */
+class AssetBundle
+{
+public:
+    /// How an image is stored in the bundle
+    enum class Format { Encoded, Raw };
+
+private:
+    /**
+     * Index entry for one image
+     */
+    struct Entry
+    {
+        /// How the image is stored
+        Format format = Format::Encoded;
+
+        /// Image width for Format::Raw
+        int width = 0;
+
+        /// Image height for Format::Raw
+        int height = 0;
+
+        /// Offset of the data from the start of the file
+        size_t offset = 0;
+
+        /// Size of the data in bytes
+        size_t size = 0;
+    };
+
+    /// Images by file name
+    std::map<std::wstring, Entry> mEntries;
+
+    /// Start of the mapped file
+    const char* mData = nullptr;
+
+    /// Size of the mapped file
+    size_t mSize = 0;
+
+#ifdef WIN32
+    /// File mapping handle
+    void* mMapping = nullptr;
+#endif
+
+    /// Message describing the last failure
+    std::wstring mError;
+
+    void Close();
+
+public:
+    AssetBundle() = default;
+
+    virtual ~AssetBundle();
+
+    /// Copy constructor (disabled)
+    AssetBundle(const AssetBundle &) = delete;
+
+    /// Assignment operator (disabled)
+    void operator=(const AssetBundle &) = delete;
+
+    bool Open(const std::wstring& filename);
+
+    bool Save(const std::wstring& imagesDir, const std::wstring& filename, Format format);
+
+    std::shared_ptr<wxImage> Decode(const std::wstring& name) const;
+
+    /**
+     * Does the bundle contain an image?
+     * @param name Image file name relative to the images directory
+     * @return true if present
+     */
+    bool Contains(const std::wstring& name) const { return mEntries.find(name) != mEntries.end(); }
+
+    /**
+     * Get the number of images in the bundle
+     * @return Image count
+     */
+    size_t GetCount() const { return mEntries.size(); }
+
+    /**
+     * Get a description of the last failure
+     * @return Error message, empty if the last operation succeeded
+     */
+    const std::wstring& GetError() const { return mError; }
+};
+
+#endif //CANADIANEXPERIENCE_MACHINELIB_ASSETBUNDLE_H
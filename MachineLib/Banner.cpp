@@ -5,6 +5,7 @@
 
 #include "pch.h"
 #include "Banner.h"
+#include "StateHash.h"
 
 /// Scale to draw relative to the image sizes
 const double BannerScale = 0.42;
@@ -46,6 +47,17 @@ Banner::Banner(const std::wstring &imagesDir)
     mScroll.Rectangle(0,-(BannerRollHeight-BannerHeight)/2,BannerRollWidth, BannerRollHeight);
 }
 
+/**
+ * Add the images a banner uses to a list of assets to preload
+ * @param imagesDir directory for images
+ * @param assets List to add to
+ */
+void Banner::Assets(const std::wstring &imagesDir, std::vector<std::wstring> &assets)
+{
+    assets.push_back(imagesDir + BannerName);
+    assets.push_back(imagesDir + RollName);
+}
+
 /**
  * Draws banner component
  * @param graphics graphics context
@@ -96,3 +108,13 @@ void Banner::SetCountdown(double time)
     mCountdown = time;
     mTimer = time;
 }
+
+/**
+ * Add the unroll step and timer to a hash
+ * @param hash Hash to add to
+ */
+void Banner::HashState(StateHash &hash)
+{
+    hash.Add(mStep);
+    hash.Add(mTimer);
+}
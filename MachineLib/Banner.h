@@ -37,12 +37,16 @@ private:
 public:
     Banner(const std::wstring& imagesDir);
 
+    static void Assets(const std::wstring& imagesDir, std::vector<std::wstring>& assets);
+
     void Draw(std::shared_ptr<wxGraphicsContext> graphics) override;
 
     void Update(double elapsed) override;
 
     void Reset() override;
 
+    void HashState(StateHash& hash) override;
+
     void SetCountdown(double time);
 };
 
@@ -5,6 +5,7 @@
 
 #include "pch.h"
 #include "Basket.h"
+#include "StateHash.h"
 #include "Machine.h"
 #include "ContactListener.h"
 #include <b2_world_callbacks.h>
@@ -38,6 +39,16 @@ Basket::Basket(const std::wstring &imagesDir)
     mTimer = BasketDelay;
 }
 
+/**
+ * Add the images a basket uses to a list of assets to preload
+ * @param imagesDir directory for images
+ * @param assets List to add to
+ */
+void Basket::Assets(const std::wstring &imagesDir, std::vector<std::wstring> &assets)
+{
+    assets.push_back(imagesDir + BasketName);
+}
+
 /**
  * Draws basket
  * @param graphics graphics context
@@ -123,3 +134,13 @@ void Basket::BeginContact(b2Contact *contact)
     b2ContactListener::BeginContact(contact);
     mIsCounting = true;
 }
+
+/**
+ * Add the launch countdown to a hash
+ * @param hash Hash to add to
+ */
+void Basket::HashState(StateHash &hash)
+{
+    hash.Add(mIsCounting);
+    hash.Add(mTimer);
+}
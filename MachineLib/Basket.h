@@ -47,6 +47,8 @@ private:
 public:
     Basket(const std::wstring& imagesDir);
 
+    static void Assets(const std::wstring& imagesDir, std::vector<std::wstring>& assets);
+
     void Draw(std::shared_ptr<wxGraphicsContext> graphics) override;
 
     void Update(double elapsed) override;
@@ -57,6 +59,8 @@ public:
 
     void Reset() override;
 
+    void HashState(StateHash& hash) override;
+
     void BeginContact(b2Contact* contact) override;
 
 
@@ -0,0 +1,153 @@
+/**
+ * @file BinaryStream.h
+ * @author djmik
+ *
+ * Helpers for reading and writing the binary resource formats
+ */
+
+#ifndef CANADIANEXPERIENCE_MACHINELIB_BINARYSTREAM_H
+#define CANADIANEXPERIENCE_MACHINELIB_BINARYSTREAM_H
+
+#include <cstring>
+#include <vector>
+
+/**
+ * Appends values to a binary resource buffer
+ */
+class BinaryWriter
+{
+private:
+    /// Bytes written so far
+    std::vector<char> mBuffer;
+
+public:
+    /**
+     * Append a plain value
+     * @param value Value to append
+     */
+    template<typename T> void Write(const T& value)
+    {
+        auto bytes = reinterpret_cast<const char*>(&value);
+        mBuffer.insert(mBuffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    /**
+     * Append a string as a UTF-8 byte count and bytes
+     * @param str String to append
+     */
+    void WriteString(const std::wstring& str)
+    {
+        auto utf8 = wxString(str).ToUTF8();
+        Write<uint32_t>(utf8.length());
+        mBuffer.insert(mBuffer.end(), utf8.data(), utf8.data() + utf8.length());
+    }
+
+    /**
+     * Append raw bytes
+     * @param data Bytes to append
+     * @param size Number of bytes
+     */
+    void WriteBytes(const void* data, size_t size)
+    {
+        auto bytes = static_cast<const char*>(data);
+        mBuffer.insert(mBuffer.end(), bytes, bytes + size);
+    }
+
+    /**
+     * Pad with zeros until the size is a multiple of alignment
+     * @param alignment Alignment in bytes
+     */
+    void Align(size_t alignment)
+    {
+        mBuffer.resize((mBuffer.size() + alignment - 1) / alignment * alignment, 0);
+    }
+
+    /**
+     * Get the bytes written
+     * @return Buffer
+     */
+    const std::vector<char>& GetBuffer() const { return mBuffer; }
+};
+
+/**
+ * Reads values back out of a binary resource buffer
+ */
+class BinaryReader
+{
+private:
+    /// Bytes being read
+    const char* mData;
+
+    /// Number of bytes that can be read
+    size_t mSize;
+
+    /// Position of the next read
+    size_t mPosition = 0;
+
+    /// Set if a read ran past the end of the buffer
+    bool mOverrun = false;
+
+public:
+    /**
+     * Constructor
+     * @param data Bytes to read
+     * @param size Number of bytes
+     */
+    BinaryReader(const char* data, size_t size) : mData(data), mSize(size) {}
+
+    /**
+     * Constructor
+     * @param buffer Bytes to read
+     */
+    explicit BinaryReader(const std::vector<char>& buffer) : BinaryReader(buffer.data(), buffer.size()) {}
+
+    /**
+     * Read a plain value
+     * @return Value, or a default value if the buffer is exhausted
+     */
+    template<typename T> T Read()
+    {
+        T value{};
+        if (mPosition + sizeof(T) > mSize)
+        {
+            mOverrun = true;
+            return value;
+        }
+
+        std::memcpy(&value, mData + mPosition, sizeof(T));
+        mPosition += sizeof(T);
+        return value;
+    }
+
+    /**
+     * Read a string written by BinaryWriter::WriteString
+     * @return String
+     */
+    std::wstring ReadString()
+    {
+        auto length = Read<uint32_t>();
+        if (mPosition + length > mSize)
+        {
+            mOverrun = true;
+            return std::wstring();
+        }
+
+        auto str = wxString::FromUTF8(mData + mPosition, length);
+        mPosition += length;
+        return str.ToStdWstring();
+    }
+
+    /**
+     * Get the position of the next read
+     * @return Offset from the start of the data
+     */
+    size_t GetPosition() const { return mPosition; }
+
+    /**
+     * Has any read run past the end of the buffer?
+     * @return true if the buffer was too short
+     */
+    bool IsOverrun() const { return mOverrun; }
+};
+
+#endif //CANADIANEXPERIENCE_MACHINELIB_BINARYSTREAM_H
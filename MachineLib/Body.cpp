@@ -93,7 +93,8 @@ void Body::SetPosition(int x, int y)
 void Body::SetMachine(Machine *machine)
 {
     Component::SetMachine(machine);
-    mBody.InstallPhysics(machine->GetWorld());
+    // Static bodies are merged into one body the machine owns
+    mBody.InstallPhysics(machine->GetWorld(), mBody.IsStatic() ? machine->GetStaticBody() : nullptr);
 }
 
 /**
@@ -77,6 +77,20 @@ public:
 
     void Circle(double radius);
 
+    /**
+     * Set the physics characteristics of the body
+     * @param density Density in kg/m^2
+     * @param friction Friction coefficient in the range [0, 1]
+     * @param restitution Restitution value in the range [0, 1]
+     */
+    void SetPhysics(double density, double friction, double restitution) { mBody.SetPhysics(density, friction, restitution); }
+
+    /**
+     * Supply precomputed physics shape vertices for the body
+     * @param vertices Vertices in meters, adjusted for the Box2D skin
+     */
+    void SetShapeVertices(const std::vector<b2Vec2>& vertices) { mBody.SetShapeVertices(vertices); }
+
     /**
      * Gets the corresponding rotation sink attatched to this body
      * @return rotation sink
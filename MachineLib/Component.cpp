@@ -5,4 +5,21 @@
 
 #include "pch.h"
 #include "Component.h"
+#include "StateHash.h"
+
+/**
+ * Add the state of the component that is not held in physics
+ * bodies to a hash
+ *
+ * StateRecorder hashes this along with every body each frame, so two
+ * runs of a machine can be compared to find the first frame and the
+ * component where they differ. Anything that affects how the machine
+ * runs and is not in a b2Body belongs here. Components with state
+ * beyond their rotation override this.
+ * @param hash Hash to add to
+ */
+void Component::HashState(StateHash &hash)
+{
+    hash.Add(GetRotation());
+}
 
@@ -11,6 +11,7 @@
 
 class b2World;
 class Machine;
+class StateHash;
 
 /**
  * Virtual component class
@@ -93,6 +94,8 @@ public:
      * @return 0
      */
     virtual double GetRotation() { return 0; }
+
+    virtual void HashState(StateHash& hash);
 };
 
 #endif //CANADIANEXPERIENCE_MACHINELIB_COMPONENT_H
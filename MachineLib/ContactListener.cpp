@@ -7,6 +7,7 @@
 #include <b2_contact.h>
 
 #include "ContactListener.h"
+#include "Trace.h"
 
 /**
  * Handle a contact beginning
@@ -14,6 +15,7 @@
  */
 void ContactListener::BeginContact(b2Contact *contact)
 {
+    TRACE_SCOPE("begin contact", "contact");
     b2ContactListener* listener = nullptr;
     if(ShouldDispatch(contact, 1, listener))
     {
@@ -33,6 +35,7 @@ void ContactListener::BeginContact(b2Contact *contact)
  */
 void ContactListener::PreSolve(b2Contact *contact, const b2Manifold *oldManifold)
 {
+    TRACE_SCOPE("presolve", "contact");
     b2ContactListener* listener = nullptr;
     if(ShouldDispatch(contact, 1, listener))
     {
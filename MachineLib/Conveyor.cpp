@@ -5,6 +5,7 @@
 
 #include "pch.h"
 #include "Conveyor.h"
+#include "StateHash.h"
 #include "RotationSink.h"
 #include "Machine.h"
 #include "ContactListener.h"
@@ -35,6 +36,16 @@ Conveyor::Conveyor(const std::wstring& imagesDir): Component()
     mConveyor.SetImage(imagesDir+ConveyorImageName);
 }
 
+/**
+ * Add the images a conveyor uses to a list of assets to preload
+ * @param imagesDir directory for images
+ * @param assets List to add to
+ */
+void Conveyor::Assets(const std::wstring &imagesDir, std::vector<std::wstring> &assets)
+{
+    assets.push_back(imagesDir + ConveyorImageName);
+}
+
 /**
  * Draw conveyor polygon image
  * @param graphics graphics context
@@ -109,3 +120,12 @@ void Conveyor::SetMachine(Machine *machine)
     machine->GetContactListener()->Add(mConveyor.GetBody(), this);
 }
 
+/**
+ * Add whether the belt is moving and its speed to a hash
+ * @param hash Hash to add to
+ */
+void Conveyor::HashState(StateHash &hash)
+{
+    hash.Add(mIsMoving);
+    hash.Add(mSpeed);
+}
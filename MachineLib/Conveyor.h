@@ -37,12 +37,16 @@ private:
 public:
     Conveyor(const std::wstring& imagesDir);
 
+    static void Assets(const std::wstring& imagesDir, std::vector<std::wstring>& assets);
+
     void Draw(std::shared_ptr<wxGraphicsContext> graphics) override;
 
     void PreSolve(b2Contact *contact, const b2Manifold *oldManifold) override;
 
     void Update(double elapsed) override;
 
+    void HashState(StateHash& hash) override;
+
     void SetPosition(int x, int y) override;
 
     void SetMachine(Machine * machine) override;
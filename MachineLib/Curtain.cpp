@@ -5,6 +5,7 @@
 
 #include "pch.h"
 #include "Curtain.h"
+#include "StateHash.h"
 
 /// Height of our curtains in pixels converted to cm
 const double CurtainHeight = 550/1.5;
@@ -42,6 +43,18 @@ Curtain::Curtain(const std::wstring &imagesDir)
     mRight.Rectangle(0,0,CurtainWidth/2,CurtainHeight);
 }
 
+/**
+ * Add the images a curtain uses to a list of assets to preload
+ * @param imagesDir directory for images
+ * @param assets List to add to
+ */
+void Curtain::Assets(const std::wstring &imagesDir, std::vector<std::wstring> &assets)
+{
+    assets.push_back(imagesDir + RodImage);
+    assets.push_back(imagesDir + LeftImage);
+    assets.push_back(imagesDir + RightImage);
+}
+
 /**
  * Draws curtains component
  * Also transfroms the graphics to shrink the curtains to the sides
@@ -90,3 +103,11 @@ void Curtain::Reset()
     mStep = 1;
 }
 
+/**
+ * Add how far the curtains are open to a hash
+ * @param hash Hash to add to
+ */
+void Curtain::HashState(StateHash &hash)
+{
+    hash.Add(mStep);
+}
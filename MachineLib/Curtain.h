@@ -36,12 +36,16 @@ private:
 public:
     Curtain(const std::wstring &imagesDir);
 
+    static void Assets(const std::wstring& imagesDir, std::vector<std::wstring>& assets);
+
     void Draw(std::shared_ptr<wxGraphicsContext> graphics) override;
 
     void Update(double elapsed) override;
 
     void Reset() override;
 
+    void HashState(StateHash& hash) override;
+
 };
 
 #endif //CANADIANEXPERIENCE_MACHINELIB_CURTAIN_H
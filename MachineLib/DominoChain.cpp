@@ -0,0 +1,347 @@
+/**
+ * @file DominoChain.cpp
+ * @author djmik
+ */
+
+#include "pch.h"
+#include <cmath>
+#include <b2_world.h>
+#include <b2_body.h>
+#include <b2_fixture.h>
+#include <b2_chain_shape.h>
+#include "DominoChain.h"
+#include "DominoFactory.h"
+#include "ShapeCache.h"
+#include "ImageCache.h"
+#include "TextureAtlas.h"
+#include "Machine.h"
+#include "Consts.h"
+#include "Trace.h"
+
+/// Density of a domino in kg/m^2
+const float DominoDensity = 1.0f;
+
+/// Friction of a domino
+const float DominoFriction = 0.5f;
+
+/// Restitution of a domino
+const float DominoRestitution = 0.5f;
+
+/// Color the ground is drawn in
+const wxColour GroundColor = wxColour(90, 70, 50);
+
+/// Width of the line the ground is drawn with in centimeters
+const int GroundWidth = 2;
+
+/// Farthest any part of a domino is from the center of its base in centimeters
+const double DominoReach = std::hypot(DominoFactory::DominoWidth / 2, DominoFactory::DominoHeight);
+
+/**
+ * Constructor
+ * @param resourcesDir Resources directory
+ * @param color Domino color, as for DominoFactory::Image
+ */
+DominoChain::DominoChain(const std::wstring &resourcesDir, int color) :
+    mImageFile(DominoFactory::Image(resourcesDir, color))
+{
+}
+
+/**
+ * Add the images of every domino color to a list of assets to preload
+ * @param resourcesDir Resources directory
+ * @param assets List to add to
+ */
+void DominoChain::Assets(const std::wstring &resourcesDir, std::vector<std::wstring> &assets)
+{
+    DominoFactory::Assets(resourcesDir, assets);
+}
+
+/**
+ * Add a point to the path the dominoes stand on
+ *
+ * The path must be complete before the chain is added to a machine.
+ * @param x X in centimeters relative to the chain position
+ * @param y Y in centimeters relative to the chain position
+ */
+void DominoChain::AddPoint(double x, double y)
+{
+    mPath.push_back(wxPoint2DDouble(x, y));
+    mPlacements.clear();
+}
+
+/**
+ * Add an arc to the path the dominoes stand on
+ * @param x X of the arc center in centimeters relative to the chain position
+ * @param y Y of the arc center in centimeters relative to the chain position
+ * @param radius Arc radius in centimeters
+ * @param start Angle the arc starts at in turns
+ * @param end Angle the arc ends at in turns
+ * @param steps Number of straight segments the arc is made of
+ */
+void DominoChain::AddArc(double x, double y, double radius, double start, double end, int steps)
+{
+    steps = std::max(1, steps);
+    for (int i = 0; i <= steps; i++)
+    {
+        double angle = (start + (end - start) * i / steps) * M_PI * 2;
+        AddPoint(x + radius * cos(angle), y + radius * sin(angle));
+    }
+}
+
+/**
+ * Set the position of the chain
+ * @param x X position in centimeters
+ * @param y Y position in centimeters
+ */
+void DominoChain::SetPosition(int x, int y)
+{
+    Component::SetPosition(x, y);
+    mPlacements.clear();
+}
+
+/**
+ * Compute where every domino starts
+ *
+ * Dominoes are spaced by distance along the path and stand
+ * upright to the segment they are on.
+ */
+void DominoChain::Layout()
+{
+    mPlacements.clear();
+
+    auto position = GetPosition();
+    double start = 0;
+    int index = 0;
+    for (size_t i = 1; i < mPath.size(); i++)
+    {
+        auto from = mPath[i - 1];
+        auto delta = mPath[i] - from;
+        double length = delta.GetVectorLength();
+        if (length <= 0)
+        {
+            continue;
+        }
+
+        auto direction = delta / length;
+        auto angle = (float)atan2(direction.m_y, direction.m_x);
+
+        // Distance is measured from the start of the path each time,
+        // so long paths do not accumulate rounding
+        for (double along = index * mSpacing - start; along <= length + 1e-9; along = ++index * mSpacing - start)
+        {
+            auto point = position + from + direction * along;
+            mPlacements.push_back({b2Vec2(point.m_x / Consts::MtoCM, point.m_y / Consts::MtoCM), angle});
+        }
+
+        start += length;
+    }
+
+    // A path that is a single point holds a single domino
+    if (mPlacements.empty() && !mPath.empty())
+    {
+        auto point = position + mPath[0];
+        mPlacements.push_back({b2Vec2(point.m_x / Consts::MtoCM, point.m_y / Consts::MtoCM), 0});
+    }
+
+    if (!mPlacements.empty())
+    {
+        // Negative is clockwise, which tips the top along the path
+        mPlacements[0].angle -= (float)(mLean * M_PI * 2);
+    }
+}
+
+/**
+ * Get the number of dominoes in the chain
+ * @return Domino count
+ */
+size_t DominoChain::GetCount()
+{
+    if (mPlacements.empty())
+    {
+        Layout();
+    }
+
+    return mPlacements.size();
+}
+
+/**
+ * Set the machine and create every domino body in its world
+ *
+ * One shared shape and one fixture definition are reused for every
+ * domino, so each body costs only Box2D's own allocation.
+ * @param machine Machine this chain belongs to
+ */
+void DominoChain::SetMachine(Machine *machine)
+{
+    Component::SetMachine(machine);
+    TRACE_SCOPE("create domino chain", "machine");
+
+    if (mPlacements.empty())
+    {
+        Layout();
+    }
+
+    auto world = machine->GetWorld();
+    auto width = DominoFactory::DominoWidth;
+    auto height = DominoFactory::DominoHeight;
+    auto shape = ShapeCache::Polygon({
+        wxPoint2DDouble(-width / 2, 0), wxPoint2DDouble(width / 2, 0),
+        wxPoint2DDouble(width / 2, height), wxPoint2DDouble(-width / 2, height)});
+
+    b2FixtureDef fixtureDef;
+    fixtureDef.shape = shape.get();
+    fixtureDef.density = DominoDensity;
+    fixtureDef.friction = DominoFriction;
+    fixtureDef.restitution = DominoRestitution;
+
+    b2BodyDef bodyDefinition;
+    bodyDefinition.type = b2_dynamicBody;
+
+    mBodies.clear();
+    mBodies.reserve(mPlacements.size());
+    for (size_t i = 0; i < mPlacements.size(); i++)
+    {
+        // Standing dominoes have nothing to do until they are hit
+        bodyDefinition.awake = i == 0 && mLean != 0;
+        bodyDefinition.position = mPlacements[i].position;
+        bodyDefinition.angle = mPlacements[i].angle;
+
+        auto body = world->CreateBody(&bodyDefinition);
+        body->CreateFixture(&fixtureDef);
+        mBodies.push_back(body);
+    }
+
+    if (mGround && mPath.size() >= 2)
+    {
+        // Box2D rejects chains with points closer together than its
+        // tolerance, so repeated points are dropped as Layout skips
+        // zero length segments
+        auto position = GetPosition();
+        std::vector<b2Vec2> points;
+        for (auto point : mPath)
+        {
+            b2Vec2 vertex((position.m_x + point.m_x) / Consts::MtoCM,
+                          (position.m_y + point.m_y) / Consts::MtoCM);
+            if (points.empty() || b2DistanceSquared(points.back(), vertex) > b2_linearSlop * b2_linearSlop)
+            {
+                points.push_back(vertex);
+            }
+        }
+
+        if (points.size() < 2)
+        {
+            return;
+        }
+
+        // Ghost vertices continue the end segments straight on
+        b2ChainShape chain;
+        chain.CreateChain(points.data(), (int32)points.size(),
+                          points[0] + points[0] - points[1],
+                          points.back() + points.back() - points[points.size() - 2]);
+
+        // The ground joins the machine's merged static body if it has one
+        auto ground = machine->GetStaticBody();
+        if (ground == nullptr)
+        {
+            b2BodyDef groundDefinition;
+            ground = world->CreateBody(&groundDefinition);
+        }
+
+        ground->CreateFixture(&chain, 0);
+    }
+}
+
+/**
+ * Update the chain. Dominoes are moved by the physics system only.
+ * @param elapsed Time since last update
+ */
+void DominoChain::Update(double elapsed)
+{
+}
+
+/**
+ * Reset the chain to its initial state
+ *
+ * The bodies belonged to the previous world. They are created
+ * again when the machine sets itself on the chain.
+ */
+void DominoChain::Reset()
+{
+    Component::Reset();
+    mBodies.clear();
+}
+
+/**
+ * Draw every domino with the shared bitmap
+ *
+ * Dominoes outside the clipping box are skipped, and the rest only
+ * change the transform between bitmap draws.
+ * @param graphics Graphics context to draw on
+ */
+void DominoChain::Draw(std::shared_ptr<wxGraphicsContext> graphics)
+{
+    if (mGround && mPath.size() >= 2)
+    {
+        auto position = GetPosition();
+        auto path = graphics->CreatePath();
+        path.MoveToPoint(position + mPath[0]);
+        for (size_t i = 1; i < mPath.size(); i++)
+        {
+            path.AddLineToPoint(position + mPath[i]);
+        }
+
+        graphics->SetPen(wxPen(GroundColor, GroundWidth));
+        graphics->StrokePath(path);
+    }
+
+    if (mBodies.empty())
+    {
+        return;
+    }
+
+    // Bitmaps belong to the renderer that created them
+    if (mBitmap.IsNull() || mRenderer != graphics->GetRenderer())
+    {
+        mRenderer = graphics->GetRenderer();
+        mBitmap = TextureAtlas::GetBitmap(graphics, mImageFile);
+        if (mBitmap.IsNull())
+        {
+            auto image = ImageCache::Load(mImageFile);
+            if (image == nullptr)
+            {
+                return;
+            }
+
+            mBitmap = graphics->CreateBitmapFromImage(*image);
+        }
+    }
+
+    wxDouble clipX, clipY, clipWidth, clipHeight;
+    graphics->GetClipBox(&clipX, &clipY, &clipWidth, &clipHeight);
+    bool cull = clipWidth > 0 && clipHeight > 0;
+
+    auto width = DominoFactory::DominoWidth;
+    auto height = DominoFactory::DominoHeight;
+    auto transform = graphics->GetTransform();
+    for (auto body : mBodies)
+    {
+        auto& position = body->GetPosition();
+        double x = position.x * Consts::MtoCM;
+        double y = position.y * Consts::MtoCM;
+        if (cull && (x + DominoReach < clipX || x - DominoReach > clipX + clipWidth ||
+                     y + DominoReach < clipY || y - DominoReach > clipY + clipHeight))
+        {
+            continue;
+        }
+
+        graphics->SetTransform(transform);
+        graphics->Translate(x, y);
+        graphics->Rotate(body->GetAngle());
+
+        // Flip the bitmap upside down, as Polygon does
+        graphics->Scale(1, -1);
+        graphics->DrawBitmap(mBitmap, -width / 2, -height, width, height);
+    }
+
+    graphics->SetTransform(transform);
+}
@@ -0,0 +1,111 @@
+/**
+ * @file DominoChain.h
+ * @author djmik
+ *
+ * A chain of dominoes laid along a path
+ */
+
+#ifndef CANADIANEXPERIENCE_MACHINELIB_DOMINOCHAIN_H
+#define CANADIANEXPERIENCE_MACHINELIB_DOMINOCHAIN_H
+
+#include <b2_math.h>
+#include "Component.h"
+
+class b2Body;
+
+/**
+ * Domino chain component class
+ *
+ * Stands dominoes at even spacing along a polyline, upright to the
+ * path they stand on. Every domino shares one shape definition and
+ * one bitmap, and the chain holds only a body pointer per domino,
+ * so tens of thousands can be created and drawn in a single pass.
+ *
+ * Dominoes start asleep and wake when something knocks into them.
+ * Leaning the first one starts the chain on its own.
+ */
+class DominoChain : public Component
+{
+private:
+    /**
+     * Where a domino starts
+     */
+    struct Placement
+    {
+        /// Center of the base in meters
+        b2Vec2 position;
+
+        /// Angle in radians
+        float angle;
+    };
+
+    /// Image every domino is drawn with
+    std::wstring mImageFile;
+
+    /// Path the dominoes stand on in centimeters, relative to the position
+    std::vector<wxPoint2DDouble> mPath;
+
+    /// Distance between dominoes along the path in centimeters
+    double mSpacing = 15;
+
+    /// How far the first domino leans forward in turns
+    double mLean = 0;
+
+    /// Is the path itself a static surface?
+    bool mGround = false;
+
+    /// Where each domino starts, computed from the path
+    std::vector<Placement> mPlacements;
+
+    /// Physics body of each domino, in path order
+    std::vector<b2Body*> mBodies;
+
+    /// Shared bitmap the dominoes are drawn with
+    wxGraphicsBitmap mBitmap;
+
+    /// Renderer that created mBitmap
+    wxGraphicsRenderer* mRenderer = nullptr;
+
+    void Layout();
+
+public:
+    DominoChain(const std::wstring& resourcesDir, int color);
+
+    static void Assets(const std::wstring& resourcesDir, std::vector<std::wstring>& assets);
+
+    void AddPoint(double x, double y);
+
+    void AddArc(double x, double y, double radius, double start, double end, int steps = 16);
+
+    /**
+     * Set the distance between dominoes along the path
+     * @param spacing Spacing in centimeters
+     */
+    void SetSpacing(double spacing) { mSpacing = spacing > 0 ? spacing : mSpacing; mPlacements.clear(); }
+
+    /**
+     * Lean the first domino forward so the chain falls by itself
+     * @param lean Lean in turns
+     */
+    void SetLean(double lean) { mLean = lean; mPlacements.clear(); }
+
+    /**
+     * Make the path a static surface for the dominoes to stand on
+     * @param ground true to create the surface
+     */
+    void SetGround(bool ground) { mGround = ground; }
+
+    void SetPosition(int x, int y) override;
+
+    void SetMachine(Machine* machine) override;
+
+    void Update(double elapsed) override;
+
+    void Draw(std::shared_ptr<wxGraphicsContext> graphics) override;
+
+    void Reset() override;
+
+    size_t GetCount();
+};
+
+#endif //CANADIANEXPERIENCE_MACHINELIB_DOMINOCHAIN_H
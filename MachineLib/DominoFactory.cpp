@@ -23,39 +23,54 @@ const std::wstring blue = L"/domino-blue.png";
 const std::wstring black = L"/domino-black.png";
 
 /**
- * Create a domino with a specified color
+ * Get the image of a domino with a specified color
  * 0/default = green
  * 1 = red
  * 2 = blue
  * 3 = black
  * @param resourcesDir image resource directory
  * @param color color of domino
- * @return domino body component
+ * @return image file name
  */
-std::shared_ptr<Body> DominoFactory::Create(const std::wstring &resourcesDir, int color)
+std::wstring DominoFactory::Image(const std::wstring &resourcesDir, int color)
 {
-
-    auto domino = std::make_shared<Body>();
-    domino->Rectangle(0,0,5,20);
     switch(color) {
-        case (0):
-            domino->SetImage(resourcesDir+ImagesDirectory+green);
-            break;
         case (1):
-            domino->SetImage(resourcesDir+ImagesDirectory+red);
-            break;
+            return resourcesDir+ImagesDirectory+red;
         case (2):
-            domino->SetImage(resourcesDir+ImagesDirectory+blue);
-            break;
+            return resourcesDir+ImagesDirectory+blue;
         case (3):
-            domino->SetImage(resourcesDir+ImagesDirectory+black);
-            break;
+            return resourcesDir+ImagesDirectory+black;
         default:
-            domino->SetImage(resourcesDir+ImagesDirectory+green);
-            break;
-
+            return resourcesDir+ImagesDirectory+green;
     }
+}
 
+/**
+ * Create a domino with a specified color
+ * @param resourcesDir image resource directory
+ * @param color color of domino, as for Image
+ * @return domino body component
+ */
+std::shared_ptr<Body> DominoFactory::Create(const std::wstring &resourcesDir, int color)
+{
+
+    auto domino = std::make_shared<Body>();
+    domino->Rectangle(0,0,DominoWidth,DominoHeight);
+    domino->SetImage(Image(resourcesDir, color));
     domino->SetDynamic();
     return domino;
 }
+
+/**
+ * Add the images of every domino color to a list of assets to preload
+ * @param resourcesDir image resource directory
+ * @param assets List to add to
+ */
+void DominoFactory::Assets(const std::wstring &resourcesDir, std::vector<std::wstring> &assets)
+{
+    for (const auto& image : {green, red, blue, black})
+    {
+        assets.push_back(resourcesDir + ImagesDirectory + image);
+    }
+}
@@ -18,7 +18,17 @@ class DominoFactory
 private:
 
 public:
+    /// Width of a domino in centimeters
+    static constexpr double DominoWidth = 5;
+
+    /// Height of a domino in centimeters
+    static constexpr double DominoHeight = 20;
+
     static std::shared_ptr<Body> Create(const std::wstring& resourcesDir, int color);
+
+    static std::wstring Image(const std::wstring& resourcesDir, int color);
+
+    static void Assets(const std::wstring& resourcesDir, std::vector<std::wstring>& assets);
 };
 
 #endif //CANADIANEXPERIENCE_MACHINELIB_DOMINOFACTORY_H
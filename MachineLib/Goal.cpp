@@ -6,6 +6,7 @@
 #include "pch.h"
 #include <b2_contact.h>
 #include "Goal.h"
+#include "StateHash.h"
 #include "Machine.h"
 #include "ContactListener.h"
 #include <sstream>
@@ -41,6 +42,13 @@ const auto ScoreboardRectangle = wxRect2DDouble(5, 280, 30, 20);
 /// scoreboard location in cm.
 const auto ScoreboardTextLocation = wxPoint2DDouble(9, 299);
 
+/// Area the scoreboard bitmap covers relative to the scoreboard
+/// location in cm, including the border and the top of the text
+const auto ScoreboardBitmapArea = wxRect2DDouble(-2, -2, 34, 26);
+
+/// Scoreboard bitmap resolution in pixels per cm
+const int ScoreboardResolution = 4;
+
 /// Position of the goalpost polygon relative to the entire goal
 /// This plus the location set by SetPosition is where to draw
 /// the goalpost PhysicsPolygon object.
@@ -72,6 +80,16 @@ Goal::Goal(const std::wstring &imagesDir) : Component()
 
 }
 
+/**
+ * Add the images a goal uses to a list of assets to preload
+ * @param imagesDir directory for images
+ * @param assets List to add to
+ */
+void Goal::Assets(const std::wstring &imagesDir, std::vector<std::wstring> &assets)
+{
+    assets.push_back(imagesDir + goalImage);
+}
+
 /**
  * draws goal component and scoreboard
  * @param graphics graphics context
@@ -81,37 +99,75 @@ void Goal::Draw(std::shared_ptr<wxGraphicsContext> graphics)
     wxPoint2DDouble position = GetPosition();
     mGoalImage.DrawPolygon(graphics,position.m_x, position.m_y,0);
 
-    double x = ScoreboardRectangle.m_x + position.m_x;
-    double y = ScoreboardRectangle.m_y + position.m_y;
-
-    wxPen pen = wxPen();
-    pen.SetColour(*wxBLACK);
-    pen.SetWidth(ScoreboarderLineWidth);
-    wxBrush brush = wxBrush();
-    brush.SetColour(ScoreboardBackgroundColor);
-
-    graphics->SetPen(pen);
-    graphics->SetBrush(brush);
-    graphics->DrawRectangle(x, y, ScoreboardRectangle.m_width, ScoreboardRectangle.m_height);
-
-    wxFont coordFont(wxSize(0, ScoreboardFontSize),
-                     wxFONTFAMILY_SWISS,
-                     wxFONTSTYLE_NORMAL,
-                     wxFONTWEIGHT_NORMAL);
-
-    graphics->SetFont(coordFont, *wxWHITE);
+    // The scoreboard only changes when the score does
+    if (mScoreboard.IsNull() || mScoreboardScore != mScore || mScoreboardRenderer != graphics->GetRenderer())
+    {
+        RenderScoreboard(graphics);
+    }
 
-    std::stringstream str;
-    str << std::setfill('0') << std::setw(2) << mScore;
+    double x = ScoreboardRectangle.m_x + position.m_x + ScoreboardBitmapArea.m_x;
+    double y = ScoreboardRectangle.m_y + position.m_y + ScoreboardBitmapArea.m_y;
 
-    x += ScoreboardTextLocation.m_x-ScoreboardRectangle.m_x;
-    y += ScoreboardTextLocation.m_y-ScoreboardRectangle.m_y+3;
     graphics->PushState();
-    graphics->Translate(x,y);
+    graphics->Translate(x, y);
     graphics->Scale(1, -1);
-    graphics->DrawText(str.str(),0,0);
+    graphics->DrawBitmap(mScoreboard, 0, -ScoreboardBitmapArea.m_height,
+                         ScoreboardBitmapArea.m_width, ScoreboardBitmapArea.m_height);
     graphics->PopState();
+}
 
+/**
+ * Render the scoreboard for the current score into a bitmap
+ *
+ * The scoreboard is drawn exactly as it would be on the machine,
+ * into an image with the Y axis flipped the same way.
+ * @param graphics Graphics context the bitmap will be drawn on
+ */
+void Goal::RenderScoreboard(std::shared_ptr<wxGraphicsContext> graphics)
+{
+    auto width = int(ScoreboardBitmapArea.m_width * ScoreboardResolution);
+    auto height = int(ScoreboardBitmapArea.m_height * ScoreboardResolution);
+
+    wxImage image(width, height);
+    image.InitAlpha();
+    memset(image.GetAlpha(), 0, width * height);
+
+    {
+        // The image is only updated when the context is destroyed
+        std::unique_ptr<wxGraphicsContext> board(wxGraphicsContext::Create(image));
+        board->Scale(ScoreboardResolution, ScoreboardResolution);
+        board->Translate(-ScoreboardBitmapArea.m_x, ScoreboardBitmapArea.GetBottom());
+        board->Scale(1, -1);
+
+        wxPen pen = wxPen();
+        pen.SetColour(*wxBLACK);
+        pen.SetWidth(ScoreboarderLineWidth);
+        wxBrush brush = wxBrush();
+        brush.SetColour(ScoreboardBackgroundColor);
+
+        board->SetPen(pen);
+        board->SetBrush(brush);
+        board->DrawRectangle(0, 0, ScoreboardRectangle.m_width, ScoreboardRectangle.m_height);
+
+        wxFont coordFont(wxSize(0, ScoreboardFontSize),
+                         wxFONTFAMILY_SWISS,
+                         wxFONTSTYLE_NORMAL,
+                         wxFONTWEIGHT_NORMAL);
+
+        board->SetFont(coordFont, *wxWHITE);
+
+        std::stringstream str;
+        str << std::setfill('0') << std::setw(2) << mScore;
+
+        board->Translate(ScoreboardTextLocation.m_x - ScoreboardRectangle.m_x,
+                         ScoreboardTextLocation.m_y - ScoreboardRectangle.m_y + 3);
+        board->Scale(1, -1);
+        board->DrawText(str.str(), 0, 0);
+    }
+
+    mScoreboard = graphics->CreateBitmapFromImage(image);
+    mScoreboardScore = mScore;
+    mScoreboardRenderer = graphics->GetRenderer();
 }
 
 /**
@@ -181,4 +237,11 @@ void Goal::Reset()
     mScore = 0;
 }
 
-
+/**
+ * Add the score to a hash
+ * @param hash Hash to add to
+ */
+void Goal::HashState(StateHash &hash)
+{
+    hash.Add(mScore);
+}
@@ -34,10 +34,23 @@ private:
     /// physics polygon handling collisions and goals of goal head/net
     cse335::PhysicsPolygon mGoal;
 
+    /// Scoreboard drawn for mScoreboardScore
+    wxGraphicsBitmap mScoreboard;
+
+    /// Score the scoreboard bitmap shows, -1 if none
+    int mScoreboardScore = -1;
+
+    /// Renderer that created the scoreboard bitmap
+    wxGraphicsRenderer* mScoreboardRenderer = nullptr;
+
+    void RenderScoreboard(std::shared_ptr<wxGraphicsContext> graphics);
+
 public:
 
     Goal(const std::wstring& imagesDir);
 
+    static void Assets(const std::wstring& imagesDir, std::vector<std::wstring>& assets);
+
     void Draw(std::shared_ptr<wxGraphicsContext> graphics) override;
 
     void BeginContact(b2Contact* contact) override;
@@ -51,6 +64,14 @@ public:
     void SetMachine(Machine * machine) override;
 
     void Reset() override;
+
+    void HashState(StateHash& hash) override;
+
+    /**
+     * Get the current score
+     * @return Points scored since the machine was reset
+     */
+    int GetScore() const { return mScore; }
 };
 
 #endif //CANADIANEXPERIENCE_MACHINELIB_GOAL_H
@@ -6,6 +6,7 @@
 #include "pch.h"
 #include <b2_contact.h>
 #include "Hamster.h"
+#include "StateHash.h"
 #include "Machine.h"
 #include "ContactListener.h"
 
@@ -43,6 +44,9 @@ const std::wstring HamsterImages[4] =
     {L"/hamster-sleep.png", L"/hamster-run-1.png",
         L"/hamster-run-2.png", L"/hamster-run-3.png"};
 
+/// Frames shown in each quarter of a running cycle
+const int RunningFrames[4] = {1, 2, 3, 2};
+
 
 /**
  * Constructor
@@ -51,11 +55,13 @@ const std::wstring HamsterImages[4] =
  */
 Hamster::Hamster(const std::wstring &imagesDir): Component()
 {
-    //hamster images same size as wheel.  Use same position
-    for (int i = 0; i < 4; i++) {
-        mHamsters[i].CenteredSquare(HamsterWheelSize);
-        mHamsters[i].SetImage(imagesDir + HamsterImages[i]);
+    std::vector<std::wstring> frames;
+    for (const auto& image : HamsterImages)
+    {
+        frames.push_back(imagesDir + image);
     }
+    mHamsters = SpriteSheet::Get(frames);
+
     mWheel.SetImage(imagesDir + HamsterWheelImage);
     mCage.SetImage(imagesDir+HamsterCageImage);
     mWheel.Circle(HamsterWheelSize/2);
@@ -63,12 +69,28 @@ Hamster::Hamster(const std::wstring &imagesDir): Component()
     mSource = std::make_shared<RotationSource>(this);
 }
 
+/**
+ * Add the images a hamster uses to a list of assets to preload
+ * @param imagesDir directory for images
+ * @param assets List to add to
+ */
+void Hamster::Assets(const std::wstring &imagesDir, std::vector<std::wstring> &assets)
+{
+    assets.push_back(imagesDir + HamsterCageImage);
+    assets.push_back(imagesDir + HamsterWheelImage);
+    for (const auto& image : HamsterImages)
+    {
+        assets.push_back(imagesDir + image);
+    }
+}
+
 /**
  * Sets hamster to be initially running or not
  * @param running true if running at start
  */
 void Hamster::SetInitiallyRunning(bool running)
 {
+    mInitiallyRunning = running;
     mIsRunning = running;
 }
 
@@ -97,26 +119,10 @@ void Hamster::BeginContact(b2Contact *contact)
  */
 void Hamster::Draw(std::shared_ptr<wxGraphicsContext> graphics) {
     double rotation = mSource->GetRotation();
-    int hamsterIndex;
-    if (mSpeed == 0.0)
+    int hamsterIndex = 0;
+    if (mIsRunning && mSpeed != 0.0)
     {
-        hamsterIndex = 0;
-    }
-    else
-    {
-        double angle = fabs(fmod(HamsterSpeed * rotation, 1));
-        if (angle < 0.25)
-        {
-            hamsterIndex = 1;
-        }
-        else if ((angle > 0.5) && (angle < 0.75))
-        {
-            hamsterIndex = 3;
-        }
-        else
-        {
-            hamsterIndex = 2;
-        }
+        hamsterIndex = RunningFrames[SpriteSheet::FrameAt(HamsterSpeed * rotation, 4)];
     }
 
     mCage.Draw(graphics);
@@ -131,12 +137,8 @@ void Hamster::Draw(std::shared_ptr<wxGraphicsContext> graphics) {
         graphics->Scale(-1, 1);
     }
 
-    // Draw the running image
-    if (mIsRunning) {
-        mHamsters[hamsterIndex].DrawPolygon(graphics, 0, 0, 0);
-    } else {
-        mHamsters[0].DrawPolygon(graphics, 0, 0, 0);
-    }
+    // Hamster images are the same size as the wheel and drawn in the same place
+    mHamsters->Draw(graphics, hamsterIndex, 0, 0, HamsterSize, HamsterSize);
 
     graphics->PopState();
 }
@@ -202,9 +204,21 @@ void Hamster::SetMachine(Machine *machine)
 
 /**
  * Resets the hamster to its initial state
- * sets the rotation to 0
+ * sets the rotation to 0 and puts a hamster that was
+ * woken by a contact back to sleep
  */
 void Hamster::Reset()
 {
     mSource->SetRotation(0);
-}
\ No newline at end of file
+    mIsRunning = mInitiallyRunning;
+}
+
+/**
+ * Add the running state and wheel rotation to a hash
+ * @param hash Hash to add to
+ */
+void Hamster::HashState(StateHash &hash)
+{
+    hash.Add(mIsRunning);
+    hash.Add(mSource->GetRotation());
+}
@@ -13,6 +13,7 @@
 #include "Polygon.h"
 #include "PhysicsPolygon.h"
 #include "RotationSource.h"
+#include "SpriteSheet.h"
 
 /**
  * Hamster component class
@@ -30,8 +31,11 @@ private:
     /// Whether or not the Hamster will be actually running (true if running)
     bool mIsRunning = false;
 
-    /// Array containing different polygons for each hamster image
-    cse335::Polygon mHamsters[4];
+    /// Whether the hamster is running when the machine starts
+    bool mInitiallyRunning = false;
+
+    /// Hamster animation frames, shared with every other hamster
+    std::shared_ptr<SpriteSheet> mHamsters;
 
     /// Polygon for the hamster wheel
     cse335::Polygon mWheel;
@@ -47,6 +51,8 @@ public:
     /// Constructor
     Hamster(const std::wstring& imagesDir);
 
+    static void Assets(const std::wstring& imagesDir, std::vector<std::wstring>& assets);
+
     void SetInitiallyRunning(bool running);
 
     void SetPosition(int x, int y) override;
@@ -65,6 +71,8 @@ public:
 
     void Reset() override;
 
+    void HashState(StateHash& hash) override;
+
     /**
      * Get the rotation source attached to this hamster
      * @return current rotation source
@@ -0,0 +1,298 @@
+/**
+ * @file ImageCache.cpp
+ * @author djmik
+ */
+
+#include "pch.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "ImageCache.h"
+#include "AssetBundle.h"
+#include "Trace.h"
+
+/// Decoded images by file name
+std::map<std::wstring, std::shared_ptr<wxImage>> ImageCache::mImages;
+
+/// Protects mImages and mBundles
+std::mutex ImageCache::mMutex;
+
+/// Current memory policy
+ImageCache::Policy ImageCache::mPolicy = ImageCache::Policy::Release;
+
+/// Requests answered from the cache
+std::atomic<size_t> ImageCache::mHits{0};
+
+/// Requests that had to decode an image
+std::atomic<size_t> ImageCache::mMisses{0};
+
+/// Most levels an image has, including the full size image
+int ImageCache::mMaxLevels = 4;
+
+/// Levels are not made smaller than this many pixels on either side
+const int MinimumLevelSize = 8;
+
+/// Mounted bundles and the image directory each one replaces
+std::vector<std::pair<std::wstring, std::shared_ptr<AssetBundle>>> ImageCache::mBundles;
+
+/**
+ * Get the decoded image for a file, decoding it if this is the first request
+ * @param filename Image filename
+ * @return Decoded image, or nullptr if the file could not be loaded
+ */
+std::shared_ptr<wxImage> ImageCache::Load(const std::wstring &filename)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto found = mImages.find(filename);
+        if (found != mImages.end())
+        {
+            mHits++;
+            return found->second;
+        }
+    }
+
+    // Decode without holding the lock so other threads are not blocked
+    TRACE_SCOPE("decode image", "image");
+    mMisses++;
+    auto image = LoadFromBundle(filename);
+    if (image == nullptr)
+    {
+        // Prevent error popup from wxWidgets
+        wxLogNull logNo;
+
+        image = std::make_shared<wxImage>();
+        if (!image->LoadFile(filename, wxBITMAP_TYPE_ANY))
+        {
+            return nullptr;
+        }
+    }
+
+    // If another thread decoded the same file meanwhile, keep the first
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mImages.emplace(filename, image).first->second;
+}
+
+/**
+ * Get a downscaled level of an image
+ *
+ * Level 0 is the image itself and each level after is half the size
+ * of the one before. Levels are made from the level above the first
+ * time they are asked for and cached like the images themselves.
+ * @param filename Image filename
+ * @param level Level number
+ * @return Image level, or nullptr if the image could not be loaded
+ * or does not have this level
+ */
+std::shared_ptr<wxImage> ImageCache::LoadLevel(const std::wstring &filename, int level)
+{
+    if (level <= 0)
+    {
+        return Load(filename);
+    }
+
+    auto name = filename + L"#" + std::to_wstring(level);
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto found = mImages.find(name);
+        if (found != mImages.end())
+        {
+            return found->second;
+        }
+    }
+
+    auto full = Load(filename);
+    if (full == nullptr || level >= GetLevelCount(full->GetSize()))
+    {
+        return nullptr;
+    }
+
+    auto larger = LoadLevel(filename, level - 1);
+    if (larger == nullptr)
+    {
+        return nullptr;
+    }
+
+    // Box averaging keeps the alpha channel and suits exact halving
+    TRACE_SCOPE("downscale image", "image");
+    auto image = std::make_shared<wxImage>(
+        larger->Scale(larger->GetWidth() / 2, larger->GetHeight() / 2, wxIMAGE_QUALITY_BOX_AVERAGE));
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mImages.emplace(name, image).first->second;
+}
+
+/**
+ * Get the number of levels an image of a given size has
+ * @param size Full image size in pixels
+ * @return Level count including the full size image
+ */
+int ImageCache::GetLevelCount(const wxSize &size)
+{
+    int levels = 1;
+    while (levels < mMaxLevels && (size.GetWidth() >> levels) >= MinimumLevelSize &&
+           (size.GetHeight() >> levels) >= MinimumLevelSize)
+    {
+        levels++;
+    }
+
+    return levels;
+}
+
+/**
+ * Decode a set of images in parallel
+ *
+ * Files are handed out to worker threads one at a time, so a few large
+ * images do not hold up the rest. Each file ends up in the cache exactly
+ * once no matter which thread decodes it, so the result does not depend
+ * on the order the threads run in.
+ * @param filenames Image files to decode. Duplicates are allowed.
+ * @param threads Number of worker threads, or 0 for one per core
+ * @return Decoded images in the same order as filenames, nullptr
+ * for any file that could not be loaded
+ */
+std::vector<std::shared_ptr<wxImage>> ImageCache::Preload(const std::vector<std::wstring> &filenames, unsigned threads)
+{
+    std::vector<std::shared_ptr<wxImage>> images(filenames.size());
+
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::min<unsigned>(threads, filenames.size());
+
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (auto i = next++; i < filenames.size(); i = next++)
+        {
+            images[i] = Load(filenames[i]);
+        }
+    };
+
+    // The calling thread does its share of the work
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < threads; t++)
+    {
+        workers.emplace_back(worker);
+    }
+
+    worker();
+    for (auto& thread : workers)
+    {
+        thread.join();
+    }
+
+    return images;
+}
+
+/**
+ * Release every cached image
+ *
+ * Polygons that already hold an image keep it alive.
+ */
+void ImageCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mImages.clear();
+}
+
+/**
+ * Release cached images that nothing else is using
+ * @return Number of bytes of pixel data released
+ */
+size_t ImageCache::Trim()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    size_t released = 0;
+    for (auto image = mImages.begin(); image != mImages.end(); )
+    {
+        if (image->second.use_count() == 1)
+        {
+            released += image->second->GetWidth() * image->second->GetHeight() *
+                (image->second->HasAlpha() ? 4 : 3);
+            image = mImages.erase(image);
+        }
+        else
+        {
+            ++image;
+        }
+    }
+
+    return released;
+}
+
+/**
+ * Get the memory used by decoded images in the cache
+ * @return Bytes of pixel data
+ */
+size_t ImageCache::GetMemory()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    size_t bytes = 0;
+    for (const auto& image : mImages)
+    {
+        bytes += image.second->GetWidth() * image.second->GetHeight() *
+            (image.second->HasAlpha() ? 4 : 3);
+    }
+
+    return bytes;
+}
+
+/**
+ * Decode an image from a mounted bundle
+ * @param filename Image filename
+ * @return Decoded image, or nullptr if no mounted bundle has it
+ */
+std::shared_ptr<wxImage> ImageCache::LoadFromBundle(const std::wstring &filename)
+{
+    std::vector<std::pair<std::wstring, std::shared_ptr<AssetBundle>>> bundles;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        bundles = mBundles;
+    }
+
+    for (const auto& bundle : bundles)
+    {
+        auto& dir = bundle.first;
+        if (filename.size() > dir.size() + 1 && filename.compare(0, dir.size(), dir) == 0 &&
+            filename[dir.size()] == L'/')
+        {
+            auto image = bundle.second->Decode(filename.substr(dir.size() + 1));
+            if (image != nullptr)
+            {
+                return image;
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * Read images in a directory from a bundle instead of their files
+ *
+ * Images the bundle does not contain are still read from the directory.
+ * Mounting a bundle for a directory replaces any earlier one.
+ * @param imagesDir Directory the bundle was built from
+ * @param bundle Opened bundle
+ */
+void ImageCache::Mount(const std::wstring &imagesDir, std::shared_ptr<AssetBundle> bundle)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    // A directory only has one bundle at a time
+    mBundles.erase(std::remove_if(mBundles.begin(), mBundles.end(),
+        [&imagesDir](const auto& mounted) { return mounted.first == imagesDir; }), mBundles.end());
+    mBundles.push_back({imagesDir, bundle});
+}
+
+/**
+ * Stop reading images from every mounted bundle
+ */
+void ImageCache::Unmount()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mBundles.clear();
+}
@@ -0,0 +1,125 @@
+/**
+ * @file ImageCache.h
+ * @author djmik
+ *
+ * Cache of decoded images shared by every polygon
+ */
+
+#ifndef CANADIANEXPERIENCE_MACHINELIB_IMAGECACHE_H
+#define CANADIANEXPERIENCE_MACHINELIB_IMAGECACHE_H
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <vector>
+
+class AssetBundle;
+
+/**
+ * Image cache class
+ *
+ * Each image file is decoded once and the decoded image is shared
+ * by every polygon that uses it, so a machine with thousands of
+ * identical dominoes or balls only reads each file one time.
+ *
+ * The cache may be used from worker threads building machines.
+ * Preload decodes a list of files declared up front in parallel, so
+ * building a machine does not decode its images one at a time.
+ *
+ * Images are read from a mounted AssetBundle when one contains them,
+ * and from their individual files otherwise.
+ *
+ * Each image also has downscaled levels, each half the size of the one
+ * before, so small on-screen polygons draw from a small image.
+ *
+ * Under the Release policy, polygons drop their decoded image once it
+ * has been turned into a graphics bitmap and Trim then frees images
+ * nothing uses. Anything that needs the pixels again decodes them again.
+ */
+class ImageCache
+{
+public:
+    /// What happens to decoded images once bitmaps are created from them
+    enum class Policy { Retain, Release };
+
+private:
+    /// Decoded images by file name
+    static std::map<std::wstring, std::shared_ptr<wxImage>> mImages;
+
+    /// Protects mImages and mBundles
+    static std::mutex mMutex;
+
+    /// Current memory policy
+    static Policy mPolicy;
+
+    /// Requests answered from the cache
+    static std::atomic<size_t> mHits;
+
+    /// Requests that had to decode an image
+    static std::atomic<size_t> mMisses;
+
+    /// Most levels an image has, including the full size image
+    static int mMaxLevels;
+
+    /// Mounted bundles and the image directory each one replaces
+    static std::vector<std::pair<std::wstring, std::shared_ptr<AssetBundle>>> mBundles;
+
+    static std::shared_ptr<wxImage> LoadFromBundle(const std::wstring& filename);
+
+public:
+    static std::shared_ptr<wxImage> Load(const std::wstring& filename);
+
+    static std::shared_ptr<wxImage> LoadLevel(const std::wstring& filename, int level);
+
+    static int GetLevelCount(const wxSize& size);
+
+    /**
+     * Set the most levels an image has
+     * @param levels Level count, 1 for full size images only
+     */
+    static void SetMaxLevels(int levels) { mMaxLevels = levels < 1 ? 1 : levels; }
+
+    static std::vector<std::shared_ptr<wxImage>> Preload(const std::vector<std::wstring>& filenames, unsigned threads = 0);
+
+    static void Clear();
+
+    static size_t Trim();
+
+    static size_t GetMemory();
+
+    /**
+     * Set what happens to decoded images once bitmaps are created
+     * @param policy New policy
+     */
+    static void SetPolicy(Policy policy) { mPolicy = policy; }
+
+    /**
+     * Get what happens to decoded images once bitmaps are created
+     * @return Current policy
+     */
+    static Policy GetPolicy() { return mPolicy; }
+
+    static void Mount(const std::wstring& imagesDir, std::shared_ptr<AssetBundle> bundle);
+
+    static void Unmount();
+
+    /**
+     * Get the number of images currently cached
+     * @return Number of decoded images
+     */
+    static size_t GetCount() { std::lock_guard<std::mutex> lock(mMutex); return mImages.size(); }
+
+    /**
+     * Get the number of requests answered from the cache
+     * @return Cache hits
+     */
+    static size_t GetHits() { return mHits; }
+
+    /**
+     * Get the number of requests that had to decode an image
+     * @return Cache misses
+     */
+    static size_t GetMisses() { return mMisses; }
+};
+
+#endif //CANADIANEXPERIENCE_MACHINELIB_IMAGECACHE_H
@@ -8,6 +8,8 @@
 #include "Machine.h"
 #include "b2_world.h"
 #include "ContactListener.h"
+#include "Profiler.h"
+#include "Trace.h"
 
 /// Gravity in meters per second per second
 const float Gravity = -9.8f;
@@ -44,8 +46,15 @@ void Machine::AddComponent(std::shared_ptr<Component> component)
  */
 void Machine::Draw(std::shared_ptr<wxGraphicsContext> graphics)
 {
+    if (mProfiler) {
+        ProfiledDraw(graphics);
+        return;
+    }
+
+    TRACE_SCOPE("draw", "draw");
     if (!mComponents.empty()){
         for (const auto component: mComponents) {
+            TRACE_SCOPE("component draw", "draw", typeid(*component).name());
             component->Draw(graphics);
         }
     } else {
@@ -60,14 +69,57 @@ void Machine::Draw(std::shared_ptr<wxGraphicsContext> graphics)
  */
 void Machine::Update(double elapsed)
 {
+    if (mProfiler) {
+        ProfiledUpdate(elapsed);
+        return;
+    }
+
+    TRACE_SCOPE("update", "simulation");
+
     // Call Update on all of our components so they can advance in time
 
     for(auto component: mComponents) {
+        TRACE_SCOPE("component update", "simulation", typeid(*component).name());
         component->Update(elapsed);
     }
 
     // Advance the physics system one frame in time
+    TRACE_SCOPE("physics step", "simulation");
+    mWorld->Step(elapsed, VelocityIterations, PositionIterations);
+}
+
+/**
+ * Draw the machine, recording how long each component takes
+ * @param graphics graphics context
+ */
+void Machine::ProfiledDraw(std::shared_ptr<wxGraphicsContext> graphics)
+{
+    auto start = Profiler::Now();
+    for (size_t i = 0; i < mComponents.size(); i++) {
+        auto componentStart = Profiler::Now();
+        mComponents[i]->Draw(graphics);
+        mProfiler->AddDraw(i, mComponents[i].get(), Profiler::Since(componentStart));
+    }
+    mProfiler->AddMachineDraw(Profiler::Since(start));
+}
+
+/**
+ * Update the machine, recording how long each component and
+ * each phase of the physics step takes
+ * @param elapsed time since last update call
+ */
+void Machine::ProfiledUpdate(double elapsed)
+{
+    auto start = Profiler::Now();
+    for (size_t i = 0; i < mComponents.size(); i++) {
+        auto componentStart = Profiler::Now();
+        mComponents[i]->Update(elapsed);
+        mProfiler->AddUpdate(i, mComponents[i].get(), Profiler::Since(componentStart));
+    }
+
     mWorld->Step(elapsed, VelocityIterations, PositionIterations);
+    mProfiler->AddStep(mWorld->GetProfile());
+    mProfiler->AddMachineUpdate(Profiler::Since(start));
 }
 
 /**
@@ -80,6 +132,7 @@ void Machine::Update(double elapsed)
 void Machine::Reset()
 {
     mWorld = std::make_shared<b2World>(b2Vec2(0.0f, Gravity));
+    mStaticBody = nullptr;
 
     // Create and install the contact filter
     mContactListener = std::make_shared<ContactListener>();
@@ -93,3 +146,21 @@ void Machine::Reset()
     mCurrentTime = 0;
 }
 
+/**
+ * Get the body static Body components are merged into
+ *
+ * Every floor, wall and beam becomes a fixture of this one body
+ * rather than a body of its own, which keeps the broadphase and the
+ * per-step body loops small. They are still drawn individually.
+ * @return Static body at the origin, or nullptr if merging is off
+ */
+b2Body* Machine::GetStaticBody()
+{
+    if (mMergeStatic && mStaticBody == nullptr)
+    {
+        b2BodyDef bodyDefinition;
+        mStaticBody = mWorld->CreateBody(&bodyDefinition);
+    }
+
+    return mMergeStatic ? mStaticBody : nullptr;
+}
@@ -10,8 +10,10 @@
 
 class Component;
 class b2World;
+class b2Body;
 class ContactListener;
 class MachineSystem;
+class Profiler;
 
 /**
  * machine class
@@ -36,6 +38,20 @@ private:
     /// System this machine belongs too
     MachineSystem * mSystem;
 
+    /// Profiler recording update and draw times, null when not profiling
+    std::shared_ptr<Profiler> mProfiler;
+
+    /// Static body every static Body component is a fixture of.
+    /// Created in the current world when first asked for.
+    b2Body* mStaticBody = nullptr;
+
+    /// Are static bodies merged into mStaticBody?
+    bool mMergeStatic = true;
+
+    void ProfiledDraw(std::shared_ptr<wxGraphicsContext> graphics);
+
+    void ProfiledUpdate(double elapsed);
+
 
 public:
     Machine();
@@ -77,6 +93,33 @@ public:
      * @param system new machine system
      */
     void SetSystem(MachineSystem * system) { mSystem = system; }
+
+    /**
+     * Attach a profiler to record update and draw times
+     * @param profiler Profiler, or nullptr to stop profiling
+     */
+    void SetProfiler(std::shared_ptr<Profiler> profiler) { mProfiler = profiler; }
+
+    b2Body* GetStaticBody();
+
+    /**
+     * Set whether static Body components share one physics body.
+     * Takes effect the next time the machine is reset.
+     * @param merge true to merge static bodies
+     */
+    void SetMergeStatic(bool merge) { mMergeStatic = merge; }
+
+    /**
+     * Get the number of components in the machine
+     * @return Component count
+     */
+    size_t GetComponentCount() const { return mComponents.size(); }
+
+    /**
+     * Get the components in the order they were added
+     * @return Components
+     */
+    const std::vector<std::shared_ptr<Component>>& GetComponents() const { return mComponents; }
 };
 
 #endif //CANADIANEXPERIENCE_MACHINELIB_MACHINE_H
@@ -4,6 +4,8 @@
  */
 
 #include "pch.h"
+#include "ImageCache.h"
+#include "TextureAtlas.h"
 #include "Machine.h"
 #include "Machine1Factory.h"
 #include "Body.h"
@@ -17,6 +19,17 @@
 /// Directory within resources that contains the images.
 const std::wstring ImagesDirectory = L"/images";
 
+/// Images used directly by bodies in this machine
+const std::wstring BodyImages[] = {
+    L"/floor.png",
+    L"/basketball1.png",
+    L"/basketball2.png",
+    L"/wedge.png",
+    L"/beam.png",
+    L"/arm.png",
+    L"/ball1.png",
+    L"/pulley3.png"};
+
 /**
  * Creates a unique machine numbered: machine #1
  * @param resourcesDir Directory holding images for components created
@@ -24,6 +37,12 @@ const std::wstring ImagesDirectory = L"/images";
  */
 std::shared_ptr<Machine> Machine1Factory::Create(const std::wstring &resourcesDir)
 {
+    // Decode every image in parallel before the components ask for
+    // them, then pack them so they draw from a few shared bitmaps
+    auto assets = Assets(resourcesDir);
+    ImageCache::Preload(assets);
+    TextureAtlas::Add(assets);
+
     std::shared_ptr<Machine> machine = std::make_shared<Machine>();
 
     //600x15
@@ -251,3 +270,26 @@ std::shared_ptr<Machine> Machine1Factory::Create(const std::wstring &resourcesDi
 
     return machine;
 }
+
+/**
+ * Get every image this machine uses
+ * @param resourcesDir Directory holding images for components created
+ * @return Image file names
+ */
+std::vector<std::wstring> Machine1Factory::Assets(const std::wstring &resourcesDir)
+{
+    auto imagesDir = resourcesDir + ImagesDirectory;
+
+    std::vector<std::wstring> assets;
+    for (const auto& image : BodyImages)
+    {
+        assets.push_back(imagesDir + image);
+    }
+
+    Goal::Assets(imagesDir, assets);
+    Hamster::Assets(imagesDir, assets);
+    Conveyor::Assets(imagesDir, assets);
+    DominoFactory::Assets(resourcesDir, assets);
+
+    return assets;
+}
@@ -19,6 +19,8 @@ private:
 
 public:
     static std::shared_ptr<Machine> Create(const std::wstring& resourcesDir);
+
+    static std::vector<std::wstring> Assets(const std::wstring& resourcesDir);
 };
 
 #endif //CANADIANEXPERIENCE_MACHINELIB_MACHINE1FACTORY_H
@@ -4,6 +4,8 @@
  */
 
 #include "pch.h"
+#include "ImageCache.h"
+#include "TextureAtlas.h"
 #include "Machine.h"
 #include "Machine2Factory.h"
 #include "Body.h"
@@ -18,6 +20,14 @@
 /// Directory within resources that contains the images.
 const std::wstring ImagesDirectory = L"/images";
 
+/// Images used directly by bodies in this machine
+const std::wstring BodyImages[] = {
+    L"/beam2.png",
+    L"/floor.png",
+    L"/basketball1.png",
+    L"/pulley3.png",
+    L"/domino-black.png"};
+
 /**
  * Creates a unique machine numbered: machine #1
  * @param resourcesDir Directory holding images for components created
@@ -25,6 +35,12 @@ const std::wstring ImagesDirectory = L"/images";
  */
 std::shared_ptr<Machine> Machine2Factory::Create(const std::wstring &resourcesDir)
 {
+    // Decode every image in parallel before the components ask for
+    // them, then pack them so they draw from a few shared bitmaps
+    auto assets = Assets(resourcesDir);
+    ImageCache::Preload(assets);
+    TextureAtlas::Add(assets);
+
     std::shared_ptr<Machine> machine = std::make_shared<Machine>();
 
     auto ceiling = std::make_shared<Body>();
@@ -147,3 +163,27 @@ std::shared_ptr<Machine> Machine2Factory::Create(const std::wstring &resourcesDi
 
     return machine;
 }
+
+/**
+ * Get every image this machine uses
+ * @param resourcesDir Directory holding images for components created
+ * @return Image file names
+ */
+std::vector<std::wstring> Machine2Factory::Assets(const std::wstring &resourcesDir)
+{
+    auto imagesDir = resourcesDir + ImagesDirectory;
+
+    std::vector<std::wstring> assets;
+    for (const auto& image : BodyImages)
+    {
+        assets.push_back(imagesDir + image);
+    }
+
+    Banner::Assets(imagesDir, assets);
+    Basket::Assets(imagesDir, assets);
+    Hamster::Assets(imagesDir, assets);
+    Conveyor::Assets(imagesDir, assets);
+    Curtain::Assets(imagesDir, assets);
+
+    return assets;
+}
@@ -0,0 +1,300 @@
+/**
+ * @file MachineBinary.cpp
+ * @author djmik
+ */
+
+#include "pch.h"
+#include <wx/file.h>
+#include <wx/stopwatch.h>
+#include "MachineBinary.h"
+#include "BinaryStream.h"
+#include "MachineDescription.h"
+#include "PhysicsPolygon.h"
+#include "Machine.h"
+
+/// Identifies a compiled machine file
+const char BinaryMagic[4] = {'I', 'M', 'C', 'B'};
+
+/// Version of the compiled format. Files from other versions are rejected.
+const uint32_t BinaryVersion = 1;
+
+/**
+ * Get the polygon points a body element will have
+ *
+ * This matches what Body::Rectangle and Body::AddPoint produce.
+ * @param element Body element
+ * @return Points in centimeters
+ */
+static std::vector<wxPoint2DDouble> ShapePoints(const MachineDescription::Element& element)
+{
+    std::vector<wxPoint2DDouble> points;
+    if (element.shape == MachineDescription::Shape::Rectangle)
+    {
+        auto& rect = element.rectangle;
+        points.push_back(wxPoint2DDouble(rect.m_x, rect.m_y));
+        points.push_back(wxPoint2DDouble(rect.m_x + rect.m_width, rect.m_y));
+        points.push_back(wxPoint2DDouble(rect.m_x + rect.m_width, rect.m_y + rect.m_height));
+        points.push_back(wxPoint2DDouble(rect.m_x, rect.m_y + rect.m_height));
+    }
+    else if (element.shape == MachineDescription::Shape::Polygon)
+    {
+        for (auto point : element.points)
+        {
+            // Body::AddPoint takes integer coordinates
+            points.push_back(wxPoint2DDouble((int)point.m_x, (int)point.m_y));
+        }
+    }
+
+    return points;
+}
+
+/**
+ * Compile a machine description to a file
+ *
+ * Physics vertices are computed here for every polygon body that
+ * does not already have them.
+ * @param description Description to compile
+ * @param filename File to write
+ * @return true if successful
+ */
+bool MachineBinary::Save(const MachineDescription &description, const std::wstring &filename)
+{
+    mError.clear();
+
+    BinaryWriter writer;
+    for (auto c : BinaryMagic)
+    {
+        writer.Write(c);
+    }
+
+    writer.Write(BinaryVersion);
+    writer.WriteString(description.GetName());
+
+    writer.Write<uint32_t>(description.GetAssets().size());
+    for (const auto& asset : description.GetAssets())
+    {
+        writer.WriteString(asset);
+    }
+
+    writer.Write<uint32_t>(description.GetElements().size());
+    for (const auto& element : description.GetElements())
+    {
+        auto vertices = element.vertices;
+        auto points = ShapePoints(element);
+        if (vertices.empty() && element.type == MachineDescription::Type::Body && points.size() >= 3)
+        {
+            vertices = cse335::PhysicsPolygon::ComputeShapeVertices(points);
+        }
+
+        writer.Write<int32_t>((int32_t)element.type);
+        writer.Write<int32_t>((int32_t)element.shape);
+        writer.Write<int32_t>((int32_t)element.motion);
+        writer.Write<int32_t>(element.anchor);
+        writer.Write<int32_t>(element.image);
+        writer.Write<int32_t>(element.domino);
+        writer.Write<uint32_t>(element.color.GetRGBA());
+        writer.Write<uint8_t>(element.running ? 1 : 0);
+        writer.Write(element.position.m_x);
+        writer.Write(element.position.m_y);
+        writer.Write(element.rectangle.m_x);
+        writer.Write(element.rectangle.m_y);
+        writer.Write(element.rectangle.m_width);
+        writer.Write(element.rectangle.m_height);
+        writer.Write(element.radius);
+        writer.Write(element.density);
+        writer.Write(element.friction);
+        writer.Write(element.restitution);
+        writer.Write(element.speed);
+        writer.Write(element.countdown);
+        writer.Write(element.direction.x);
+        writer.Write(element.direction.y);
+
+        writer.Write<uint32_t>(element.points.size());
+        for (auto point : element.points)
+        {
+            writer.Write(point.m_x);
+            writer.Write(point.m_y);
+        }
+
+        writer.Write<uint32_t>(vertices.size());
+        for (auto vertex : vertices)
+        {
+            writer.Write(vertex.x);
+            writer.Write(vertex.y);
+        }
+    }
+
+    writer.Write<uint32_t>(description.GetConnections().size());
+    for (const auto& connection : description.GetConnections())
+    {
+        writer.Write<int32_t>(connection.source);
+        writer.Write<int32_t>(connection.sink);
+        writer.Write(connection.ratio);
+    }
+
+    writer.Write<uint32_t>(description.GetBelts().size());
+    for (const auto& belt : description.GetBelts())
+    {
+        writer.Write<int32_t>(belt.first);
+        writer.Write<int32_t>(belt.second);
+    }
+
+    wxFile file;
+    auto& buffer = writer.GetBuffer();
+    if (!file.Create(filename, true) || file.Write(buffer.data(), buffer.size()) != buffer.size())
+    {
+        mError = L"Unable to write compiled machine '" + filename + L"'";
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Read a compiled machine file
+ * @param filename File to read
+ * @return Description, or nullptr if the file is missing or not a compiled machine
+ */
+std::shared_ptr<MachineDescription> MachineBinary::Read(const std::wstring &filename)
+{
+    // Prevent error popup from wxWidgets
+    wxLogNull logNo;
+
+    wxStopWatch watch;
+    mError.clear();
+
+    // The whole file is brought in with a single read
+    wxFile file;
+    if (!file.Open(filename))
+    {
+        mError = L"Unable to open compiled machine '" + filename + L"'";
+        return nullptr;
+    }
+
+    std::vector<char> buffer(file.Length());
+    if (file.Read(buffer.data(), buffer.size()) != (ssize_t)buffer.size())
+    {
+        mError = L"Unable to read compiled machine '" + filename + L"'";
+        return nullptr;
+    }
+
+    BinaryReader reader(buffer);
+    for (auto c : BinaryMagic)
+    {
+        if (reader.Read<char>() != c)
+        {
+            mError = L"'" + filename + L"' is not a compiled machine";
+            return nullptr;
+        }
+    }
+
+    if (reader.Read<uint32_t>() != BinaryVersion)
+    {
+        mError = L"'" + filename + L"' was compiled for a different version";
+        return nullptr;
+    }
+
+    auto description = std::make_shared<MachineDescription>();
+    description->SetName(reader.ReadString());
+
+    auto assets = reader.Read<uint32_t>();
+    for (uint32_t i = 0; i < assets && !reader.IsOverrun(); i++)
+    {
+        description->AddAsset(reader.ReadString());
+    }
+
+    auto elements = reader.Read<uint32_t>();
+    for (uint32_t i = 0; i < elements && !reader.IsOverrun(); i++)
+    {
+        MachineDescription::Element element;
+        element.type = (MachineDescription::Type)reader.Read<int32_t>();
+        element.shape = (MachineDescription::Shape)reader.Read<int32_t>();
+        element.motion = (MachineDescription::Motion)reader.Read<int32_t>();
+        element.anchor = reader.Read<int32_t>();
+        element.image = reader.Read<int32_t>();
+        element.domino = reader.Read<int32_t>();
+        element.color.SetRGBA(reader.Read<uint32_t>());
+        element.running = reader.Read<uint8_t>() != 0;
+        element.position.m_x = reader.Read<double>();
+        element.position.m_y = reader.Read<double>();
+        element.rectangle.m_x = reader.Read<double>();
+        element.rectangle.m_y = reader.Read<double>();
+        element.rectangle.m_width = reader.Read<double>();
+        element.rectangle.m_height = reader.Read<double>();
+        element.radius = reader.Read<double>();
+        element.density = reader.Read<double>();
+        element.friction = reader.Read<double>();
+        element.restitution = reader.Read<double>();
+        element.speed = reader.Read<double>();
+        element.countdown = reader.Read<double>();
+        element.direction.x = reader.Read<float>();
+        element.direction.y = reader.Read<float>();
+
+        auto points = reader.Read<uint32_t>();
+        for (uint32_t p = 0; p < points && !reader.IsOverrun(); p++)
+        {
+            auto x = reader.Read<double>();
+            auto y = reader.Read<double>();
+            element.points.push_back(wxPoint2DDouble(x, y));
+        }
+
+        auto vertices = reader.Read<uint32_t>();
+        for (uint32_t v = 0; v < vertices && !reader.IsOverrun(); v++)
+        {
+            auto x = reader.Read<float>();
+            auto y = reader.Read<float>();
+            element.vertices.push_back(b2Vec2(x, y));
+        }
+
+        description->AddElement(element);
+    }
+
+    auto connections = reader.Read<uint32_t>();
+    for (uint32_t i = 0; i < connections && !reader.IsOverrun(); i++)
+    {
+        MachineDescription::Connection connection;
+        connection.source = reader.Read<int32_t>();
+        connection.sink = reader.Read<int32_t>();
+        connection.ratio = reader.Read<double>();
+        description->AddConnection(connection);
+    }
+
+    auto belts = reader.Read<uint32_t>();
+    for (uint32_t i = 0; i < belts && !reader.IsOverrun(); i++)
+    {
+        MachineDescription::Belt belt;
+        belt.first = reader.Read<int32_t>();
+        belt.second = reader.Read<int32_t>();
+        description->AddBelt(belt);
+    }
+
+    if (reader.IsOverrun())
+    {
+        mError = L"Compiled machine '" + filename + L"' is truncated";
+        return nullptr;
+    }
+
+    mReadTime = watch.TimeInMicro().ToDouble() / 1000.0;
+    return description;
+}
+
+/**
+ * Read a compiled machine file and build the machine
+ * @param filename File to read
+ * @param resourcesDir Directory holding images for components created
+ * @return machine pointer, or nullptr if the file could not be read
+ */
+std::shared_ptr<Machine> MachineBinary::Load(const std::wstring &filename, const std::wstring &resourcesDir)
+{
+    auto description = Read(filename);
+    if (description == nullptr)
+    {
+        return nullptr;
+    }
+
+    wxStopWatch watch;
+    auto machine = description->Create(resourcesDir);
+    mBuildTime = watch.TimeInMicro().ToDouble() / 1000.0;
+
+    return machine;
+}
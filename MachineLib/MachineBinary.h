@@ -0,0 +1,62 @@
+/**
+ * @file MachineBinary.h
+ * @author djmik
+ *
+ * Compiled binary form of a machine description
+ */
+
+#ifndef CANADIANEXPERIENCE_MACHINELIB_MACHINEBINARY_H
+#define CANADIANEXPERIENCE_MACHINELIB_MACHINEBINARY_H
+
+class Machine;
+class MachineDescription;
+
+/**
+ * Machine binary class
+ *
+ * Writes and reads the compiled form of a machine description. The
+ * compiled file holds the asset table, every element with its physics
+ * vertices already scaled for Box2D, fixture parameters and connection
+ * tables by element index. Loading is a single file read; the machine
+ * is then built from the description like any other, except that body
+ * shapes use the stored vertices rather than computing them.
+ */
+class MachineBinary
+{
+private:
+    /// Time spent reading the last file in milliseconds
+    double mReadTime = 0;
+
+    /// Time spent constructing the last machine in milliseconds
+    double mBuildTime = 0;
+
+    /// Message describing the last failure
+    std::wstring mError;
+
+public:
+    bool Save(const MachineDescription& description, const std::wstring& filename);
+
+    std::shared_ptr<MachineDescription> Read(const std::wstring& filename);
+
+    std::shared_ptr<Machine> Load(const std::wstring& filename, const std::wstring& resourcesDir);
+
+    /**
+     * Get the time spent reading the last file
+     * @return Time in milliseconds
+     */
+    double GetReadTime() const { return mReadTime; }
+
+    /**
+     * Get the time spent constructing the last machine
+     * @return Time in milliseconds
+     */
+    double GetBuildTime() const { return mBuildTime; }
+
+    /**
+     * Get a description of the last failure
+     * @return Error message, empty if the last operation succeeded
+     */
+    const std::wstring& GetError() const { return mError; }
+};
+
+#endif //CANADIANEXPERIENCE_MACHINELIB_MACHINEBINARY_H
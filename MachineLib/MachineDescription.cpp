@@ -0,0 +1,336 @@
+/**
+ * @file MachineDescription.cpp
+ * @author djmik
+ */
+
+#include "pch.h"
+#include <set>
+#include "MachineDescription.h"
+#include "ImageCache.h"
+#include "TextureAtlas.h"
+#include "Machine.h"
+#include "Body.h"
+#include "Goal.h"
+#include "Pulley.h"
+#include "Hamster.h"
+#include "Conveyor.h"
+#include "Basket.h"
+#include "Curtain.h"
+#include "Banner.h"
+#include "DominoFactory.h"
+#include "RotationSource.h"
+#include "RotationSink.h"
+
+/// Directory within resources that contains the images.
+const std::wstring ImagesDirectory = L"/images";
+
+/**
+ * Add an image to the asset table
+ * @param image Image file name relative to the images directory
+ * @return Index of the image in the asset table
+ */
+int MachineDescription::AddAsset(const std::wstring &image)
+{
+    for (size_t i = 0; i < mAssets.size(); i++)
+    {
+        if (mAssets[i] == image)
+        {
+            return (int)i;
+        }
+    }
+
+    mAssets.push_back(image);
+    return (int)mAssets.size() - 1;
+}
+
+/**
+ * Get every image the machine will use
+ *
+ * This is the asset table plus the images of each type of component
+ * the description contains.
+ * @param resourcesDir Directory holding images for components created
+ * @return Image file names
+ */
+std::vector<std::wstring> MachineDescription::ResolveAssets(const std::wstring &resourcesDir) const
+{
+    auto imagesDir = resourcesDir + ImagesDirectory;
+
+    std::vector<std::wstring> assets;
+    for (const auto& asset : mAssets)
+    {
+        assets.push_back(imagesDir + L"/" + asset);
+    }
+
+    std::set<Type> types;
+    for (const auto& element : mElements)
+    {
+        types.insert(element.type);
+    }
+
+    for (auto type : types)
+    {
+        switch (type)
+        {
+        case Type::Domino:
+            DominoFactory::Assets(resourcesDir, assets);
+            break;
+
+        case Type::Hamster:
+            Hamster::Assets(imagesDir, assets);
+            break;
+
+        case Type::Conveyor:
+            Conveyor::Assets(imagesDir, assets);
+            break;
+
+        case Type::Basket:
+            Basket::Assets(imagesDir, assets);
+            break;
+
+        case Type::Goal:
+            Goal::Assets(imagesDir, assets);
+            break;
+
+        case Type::Curtain:
+            Curtain::Assets(imagesDir, assets);
+            break;
+
+        case Type::Banner:
+            Banner::Assets(imagesDir, assets);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    return assets;
+}
+
+/**
+ * Creates the machine this object describes
+ *
+ * Elements are added in order, so an element may only be anchored to
+ * a hamster or conveyor that appears before it.
+ * @param resourcesDir Directory holding images for components created
+ * @return machine pointer
+ */
+std::shared_ptr<Machine> MachineDescription::Create(const std::wstring &resourcesDir) const
+{
+    std::shared_ptr<Machine> machine = std::make_shared<Machine>();
+    auto imagesDir = resourcesDir + ImagesDirectory;
+
+    // Resolve each asset path once
+    std::vector<std::wstring> images;
+    for (const auto& asset : mAssets)
+    {
+        images.push_back(imagesDir + L"/" + asset);
+    }
+
+    // Decode every image in parallel before the components ask for
+    // them, then pack them so they draw from a few shared bitmaps
+    auto assets = ResolveAssets(resourcesDir);
+    ImageCache::Preload(assets);
+    TextureAtlas::Add(assets);
+
+    // What each element provides to connections and anchors, by element index
+    std::vector<std::shared_ptr<RotationSource>> sources(mElements.size());
+    std::vector<std::shared_ptr<RotationSink>> sinks(mElements.size());
+    std::vector<std::shared_ptr<Pulley>> pulleys(mElements.size());
+    std::vector<wxPoint2DDouble> shafts(mElements.size());
+
+    for (size_t i = 0; i < mElements.size(); i++)
+    {
+        const auto& element = mElements[i];
+
+        auto position = element.position;
+        if (element.anchor >= 0 && element.anchor < (int)i)
+        {
+            position = shafts[element.anchor];
+        }
+
+        switch (element.type)
+        {
+        case Type::Body:
+        {
+            auto body = std::make_shared<Body>();
+            body->SetInitialPosition(position.m_x, position.m_y);
+            switch (element.shape)
+            {
+            case Shape::Rectangle:
+                body->Rectangle(element.rectangle.m_x, element.rectangle.m_y,
+                                element.rectangle.m_width, element.rectangle.m_height);
+                break;
+
+            case Shape::Circle:
+                body->Circle(element.radius);
+                break;
+
+            default:
+                for (auto point : element.points)
+                {
+                    body->AddPoint(point.m_x, point.m_y);
+                }
+                break;
+            }
+
+            if (element.image >= 0)
+            {
+                body->SetImage(images[element.image]);
+            }
+            else
+            {
+                body->SetColor(element.color);
+            }
+
+            body->SetPhysics(element.density, element.friction, element.restitution);
+            if (!element.vertices.empty())
+            {
+                body->SetShapeVertices(element.vertices);
+            }
+
+            if (element.motion == Motion::Dynamic)
+            {
+                body->SetDynamic();
+            }
+            else if (element.motion == Motion::Kinematic)
+            {
+                body->SetKinematic();
+            }
+
+            machine->AddComponent(body);
+            sinks[i] = body->GetSink();
+            break;
+        }
+
+        case Type::Domino:
+        {
+            auto domino = DominoFactory::Create(resourcesDir, element.domino);
+            domino->SetPosition(position.m_x, position.m_y);
+            machine->AddComponent(domino);
+            break;
+        }
+
+        case Type::Hamster:
+        {
+            auto hamster = std::make_shared<Hamster>(imagesDir);
+            hamster->SetInitiallyRunning(element.running);
+            hamster->SetPosition(position.m_x, position.m_y);
+            hamster->SetSpeed(element.speed);
+            machine->AddComponent(hamster);
+            sources[i] = hamster->GetSource();
+            shafts[i] = hamster->GetShaftPosition();
+            break;
+        }
+
+        case Type::Conveyor:
+        {
+            auto conveyor = std::make_shared<Conveyor>(imagesDir);
+            conveyor->SetPosition(position.m_x, position.m_y);
+            machine->AddComponent(conveyor);
+            sinks[i] = conveyor->GetSink();
+            shafts[i] = conveyor->GetShaftPosition();
+            break;
+        }
+
+        case Type::Pulley:
+        {
+            auto pulley = std::make_shared<Pulley>(element.radius);
+            if (element.image >= 0)
+            {
+                pulley->SetImage(images[element.image]);
+            }
+            pulley->SetPosition(position.m_x, position.m_y);
+            machine->AddComponent(pulley);
+            sources[i] = pulley->GetSource();
+            sinks[i] = pulley->GetSink();
+            pulleys[i] = pulley;
+            break;
+        }
+
+        case Type::Basket:
+        {
+            auto basket = std::make_shared<Basket>(imagesDir);
+            basket->SetPosition(position.m_x, position.m_y);
+            basket->SetDirection(element.direction);
+            machine->AddComponent(basket);
+            break;
+        }
+
+        case Type::Goal:
+        {
+            auto goal = std::make_shared<Goal>(imagesDir);
+            goal->SetPosition(position.m_x, position.m_y);
+            machine->AddComponent(goal);
+            break;
+        }
+
+        case Type::Curtain:
+        {
+            auto curtain = std::make_shared<Curtain>(imagesDir);
+            curtain->SetPosition(position.m_x, position.m_y);
+            machine->AddComponent(curtain);
+            break;
+        }
+
+        case Type::Banner:
+        {
+            auto banner = std::make_shared<Banner>(imagesDir);
+            banner->SetPosition(position.m_x, position.m_y);
+            banner->SetCountdown(element.countdown);
+            machine->AddComponent(banner);
+            break;
+        }
+        }
+    }
+
+    // Connections and belts referring to an element that does not
+    // provide what they need are skipped
+    auto count = (int)mElements.size();
+    for (const auto& connection : mConnections)
+    {
+        if (connection.source < 0 || connection.source >= count ||
+            connection.sink < 0 || connection.sink >= count)
+        {
+            continue;
+        }
+
+        auto& source = sources[connection.source];
+        auto& sink = sinks[connection.sink];
+        if (source == nullptr || sink == nullptr)
+        {
+            continue;
+        }
+
+        // Pulley to pulley connections default to the ratio of the radii
+        double ratio = connection.ratio;
+        if (ratio <= 0)
+        {
+            auto& first = pulleys[connection.source];
+            auto& second = pulleys[connection.sink];
+            ratio = (first != nullptr && second != nullptr) ? first->GetRadius() / second->GetRadius() : 1;
+        }
+
+        source->Connect(source, sink, ratio);
+    }
+
+    for (const auto& belt : mBelts)
+    {
+        if (belt.first < 0 || belt.first >= count || belt.second < 0 || belt.second >= count)
+        {
+            continue;
+        }
+
+        auto& first = pulleys[belt.first];
+        auto& second = pulleys[belt.second];
+        if (first == nullptr || second == nullptr)
+        {
+            continue;
+        }
+
+        first->SetOtherPulley(second);
+        second->SetOtherPulley(first);
+    }
+
+    return machine;
+}
@@ -0,0 +1,215 @@
+/**
+ * @file MachineDescription.h
+ * @author djmik
+ *
+ * Data-only description of a machine that can be built into a Machine
+ */
+
+#ifndef CANADIANEXPERIENCE_MACHINELIB_MACHINEDESCRIPTION_H
+#define CANADIANEXPERIENCE_MACHINELIB_MACHINEDESCRIPTION_H
+
+#include <b2_math.h>
+
+class Machine;
+
+/**
+ * Machine description class
+ *
+ * Holds everything needed to construct a machine (components, their
+ * positions, images and rotation connections) as plain data. Descriptions
+ * are produced by MachineLoader and turned into a Machine by Create,
+ * the same way Machine1Factory and Machine2Factory do in code.
+ */
+class MachineDescription
+{
+public:
+    /// Types of component a description can hold
+    enum class Type { Body, Domino, Hamster, Conveyor, Pulley, Basket, Goal, Curtain, Banner };
+
+    /// Shape of a body component
+    enum class Shape { None, Rectangle, Circle, Polygon };
+
+    /// How a body moves in the physics system
+    enum class Motion { Static, Dynamic, Kinematic };
+
+    /**
+     * Description of a single component in the machine
+     */
+    struct Element
+    {
+        /// Type of component to create
+        Type type = Type::Body;
+
+        /// Identifier used for this element in description files
+        std::wstring id;
+
+        /// Position of the component in centimeters
+        wxPoint2DDouble position;
+
+        /// Index of a hamster or conveyor whose shaft this component
+        /// is positioned on, or -1 if it is not anchored
+        int anchor = -1;
+
+        /// Index of the image in the asset table, or -1 for none
+        int image = -1;
+
+        /// Fill color for bodies without an image
+        wxColour color;
+
+        /// Shape of a body
+        Shape shape = Shape::None;
+
+        /// Rectangle for Shape::Rectangle bodies
+        wxRect2DDouble rectangle;
+
+        /// Radius of circle bodies and pulleys
+        double radius = 0;
+
+        /// Points for Shape::Polygon bodies
+        std::vector<wxPoint2DDouble> points;
+
+        /// Physics shape vertices already scaled for Box2D. Filled in
+        /// by MachineBinary; empty means compute them at install time.
+        std::vector<b2Vec2> vertices;
+
+        /// Physics motion of a body
+        Motion motion = Motion::Static;
+
+        /// Body density in kg/m^2
+        double density = 1.0;
+
+        /// Body friction coefficient
+        double friction = 0.5;
+
+        /// Body restitution
+        double restitution = 0.5;
+
+        /// Is a hamster initially running?
+        bool running = false;
+
+        /// Hamster speed
+        double speed = 1;
+
+        /// Basket launch direction
+        b2Vec2 direction = b2Vec2(0, 5);
+
+        /// Banner countdown in seconds
+        double countdown = 1;
+
+        /// Domino color (see DominoFactory::Create)
+        int domino = 0;
+    };
+
+    /**
+     * A rotation source to rotation sink connection
+     */
+    struct Connection
+    {
+        /// Index of the component providing rotation
+        int source = -1;
+
+        /// Index of the component consuming rotation
+        int sink = -1;
+
+        /// Ratio between source and sink. Zero derives it from pulley radii.
+        double ratio = 0;
+    };
+
+    /**
+     * A belt drawn between two pulleys
+     */
+    struct Belt
+    {
+        /// Index of the first pulley
+        int first = -1;
+
+        /// Index of the second pulley
+        int second = -1;
+    };
+
+private:
+    /// Name of the machine
+    std::wstring mName;
+
+    /// Image file names relative to the images directory
+    std::vector<std::wstring> mAssets;
+
+    /// Components in the order they are added to the machine
+    std::vector<Element> mElements;
+
+    /// Rotation connections
+    std::vector<Connection> mConnections;
+
+    /// Pulley belts
+    std::vector<Belt> mBelts;
+
+public:
+    /**
+     * Set the machine name
+     * @param name New name
+     */
+    void SetName(const std::wstring& name) { mName = name; }
+
+    /**
+     * Get the machine name
+     * @return Machine name
+     */
+    const std::wstring& GetName() const { return mName; }
+
+    int AddAsset(const std::wstring& image);
+
+    /**
+     * Get the asset table
+     * @return Image file names relative to the images directory
+     */
+    const std::vector<std::wstring>& GetAssets() const { return mAssets; }
+
+    /**
+     * Add a component element
+     * @param element Element to add
+     * @return Index of the new element
+     */
+    int AddElement(const Element& element) { mElements.push_back(element); return (int)mElements.size() - 1; }
+
+    /**
+     * Get the component elements for modification
+     * @return Elements in machine order
+     */
+    std::vector<Element>& GetElements() { return mElements; }
+
+    /**
+     * Add a rotation connection
+     * @param connection Connection to add
+     */
+    void AddConnection(const Connection& connection) { mConnections.push_back(connection); }
+
+    /**
+     * Add a belt between two pulleys
+     * @param belt Belt to add
+     */
+    void AddBelt(const Belt& belt) { mBelts.push_back(belt); }
+
+    /**
+     * Get the component elements
+     * @return Elements in machine order
+     */
+    const std::vector<Element>& GetElements() const { return mElements; }
+
+    /**
+     * Get the rotation connections
+     * @return Connections
+     */
+    const std::vector<Connection>& GetConnections() const { return mConnections; }
+
+    /**
+     * Get the pulley belts
+     * @return Belts
+     */
+    const std::vector<Belt>& GetBelts() const { return mBelts; }
+
+    std::vector<std::wstring> ResolveAssets(const std::wstring& resourcesDir) const;
+
+    std::shared_ptr<Machine> Create(const std::wstring& resourcesDir) const;
+};
+
+#endif //CANADIANEXPERIENCE_MACHINELIB_MACHINEDESCRIPTION_H
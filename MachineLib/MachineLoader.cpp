@@ -0,0 +1,265 @@
+/**
+ * @file MachineLoader.cpp
+ * @author djmik
+ */
+
+#include "pch.h"
+#include <wx/xml/xml.h>
+#include <wx/stopwatch.h>
+#include <map>
+#include "MachineLoader.h"
+#include "MachineDescription.h"
+#include "Machine.h"
+
+/// Element names and the component types they create
+const std::map<wxString, MachineDescription::Type> ElementTypes = {
+    {L"body", MachineDescription::Type::Body},
+    {L"domino", MachineDescription::Type::Domino},
+    {L"hamster", MachineDescription::Type::Hamster},
+    {L"conveyor", MachineDescription::Type::Conveyor},
+    {L"pulley", MachineDescription::Type::Pulley},
+    {L"basket", MachineDescription::Type::Basket},
+    {L"goal", MachineDescription::Type::Goal},
+    {L"curtain", MachineDescription::Type::Curtain},
+    {L"banner", MachineDescription::Type::Banner}};
+
+/// Domino color names in DominoFactory order
+const wxString DominoColors[] = {L"green", L"red", L"blue", L"black"};
+
+/**
+ * Read a numeric attribute
+ * @param node XML node
+ * @param name Attribute name
+ * @param value Value to use when the attribute is missing or invalid
+ * @return Attribute value
+ */
+static double DoubleAttribute(wxXmlNode* node, const wxString& name, double value)
+{
+    double result;
+    return node->GetAttribute(name, wxEmptyString).ToDouble(&result) ? result : value;
+}
+
+/**
+ * Parse a machine description XML file
+ * @param filename File to load
+ * @return Description, or nullptr if the file could not be read
+ */
+std::shared_ptr<MachineDescription> MachineLoader::Parse(const std::wstring &filename)
+{
+    // Prevent error popup from wxWidgets
+    wxLogNull logNo;
+
+    wxStopWatch watch;
+    mError.clear();
+
+    wxXmlDocument xmlDoc;
+    if (!xmlDoc.Load(filename))
+    {
+        mError = L"Unable to load machine file '" + filename + L"'";
+        return nullptr;
+    }
+
+    auto description = XmlMachine(xmlDoc.GetRoot());
+    mParseTime = watch.TimeInMicro().ToDouble() / 1000.0;
+    return description;
+}
+
+/**
+ * Parse a machine description from a stream
+ * @param stream Stream containing the XML
+ * @return Description, or nullptr if the stream could not be read
+ */
+std::shared_ptr<MachineDescription> MachineLoader::Parse(wxInputStream &stream)
+{
+    wxLogNull logNo;
+
+    wxStopWatch watch;
+    mError.clear();
+
+    wxXmlDocument xmlDoc;
+    if (!xmlDoc.Load(stream))
+    {
+        mError = L"Unable to read machine description";
+        return nullptr;
+    }
+
+    auto description = XmlMachine(xmlDoc.GetRoot());
+    mParseTime = watch.TimeInMicro().ToDouble() / 1000.0;
+    return description;
+}
+
+/**
+ * Load a machine description XML file and build the machine
+ * @param filename File to load
+ * @param resourcesDir Directory holding images for components created
+ * @return machine pointer, or nullptr if the file could not be read
+ */
+std::shared_ptr<Machine> MachineLoader::Load(const std::wstring &filename, const std::wstring &resourcesDir)
+{
+    auto description = Parse(filename);
+    if (description == nullptr)
+    {
+        return nullptr;
+    }
+
+    wxStopWatch watch;
+    auto machine = description->Create(resourcesDir);
+    mBuildTime = watch.TimeInMicro().ToDouble() / 1000.0;
+
+    return machine;
+}
+
+/**
+ * Convert the root machine node into a description
+ * @param root Root XML node, expected to be <machine>
+ * @return Description, or nullptr if the root is not a machine
+ */
+std::shared_ptr<MachineDescription> MachineLoader::XmlMachine(wxXmlNode *root)
+{
+    if (root == nullptr || root->GetName() != L"machine")
+    {
+        mError = L"Machine file does not contain a <machine> element";
+        return nullptr;
+    }
+
+    auto description = std::make_shared<MachineDescription>();
+    description->SetName(root->GetAttribute(L"name", wxEmptyString).ToStdWstring());
+
+    // Element indices by id. Connections and belts are resolved once
+    // every element has been read, so they may appear anywhere.
+    std::map<std::wstring, int> ids;
+    std::vector<std::pair<wxXmlNode*, MachineDescription::Connection>> connections;
+    std::vector<wxXmlNode*> belts;
+
+    for (auto node = root->GetChildren(); node != nullptr; node = node->GetNext())
+    {
+        if (node->GetType() != wxXML_ELEMENT_NODE)
+        {
+            continue;
+        }
+
+        auto name = node->GetName();
+        if (name == L"connect")
+        {
+            MachineDescription::Connection connection;
+            connection.ratio = DoubleAttribute(node, L"ratio", 0);
+            connections.push_back({node, connection});
+            continue;
+        }
+
+        if (name == L"belt")
+        {
+            belts.push_back(node);
+            continue;
+        }
+
+        auto type = ElementTypes.find(name);
+        if (type == ElementTypes.end())
+        {
+            // Unknown elements are ignored so newer files still load
+            continue;
+        }
+
+        MachineDescription::Element element;
+        element.type = type->second;
+        element.id = node->GetAttribute(L"id", wxEmptyString).ToStdWstring();
+
+        auto anchor = ids.find(node->GetAttribute(L"anchor", wxEmptyString).ToStdWstring());
+        if (anchor != ids.end())
+        {
+            element.anchor = anchor->second;
+        }
+
+        auto image = node->GetAttribute(L"image", wxEmptyString).ToStdWstring();
+        if (!image.empty())
+        {
+            element.image = description->AddAsset(image);
+        }
+
+        element.position = wxPoint2DDouble(DoubleAttribute(node, L"x", 0), DoubleAttribute(node, L"y", 0));
+        element.color = wxColour(node->GetAttribute(L"color", L"black"));
+        element.radius = DoubleAttribute(node, L"radius", 0);
+        element.running = node->GetAttribute(L"running", L"false") == L"true";
+        element.speed = DoubleAttribute(node, L"speed", 1);
+        element.countdown = DoubleAttribute(node, L"countdown", 1);
+        element.direction = b2Vec2(DoubleAttribute(node, L"dx", 0), DoubleAttribute(node, L"dy", 5));
+        element.density = DoubleAttribute(node, L"density", 1.0);
+        element.friction = DoubleAttribute(node, L"friction", 0.5);
+        element.restitution = DoubleAttribute(node, L"restitution", 0.5);
+
+        auto motion = node->GetAttribute(L"motion", L"static");
+        if (motion == L"dynamic")
+        {
+            element.motion = MachineDescription::Motion::Dynamic;
+        }
+        else if (motion == L"kinematic")
+        {
+            element.motion = MachineDescription::Motion::Kinematic;
+        }
+
+        if (element.type == MachineDescription::Type::Domino)
+        {
+            auto color = node->GetAttribute(L"color", DominoColors[0]);
+            for (int i = 0; i < 4; i++)
+            {
+                if (color == DominoColors[i])
+                {
+                    element.domino = i;
+                }
+            }
+        }
+
+        // Body shapes are given as child elements
+        for (auto child = node->GetChildren(); child != nullptr; child = child->GetNext())
+        {
+            if (child->GetName() == L"rectangle")
+            {
+                element.shape = MachineDescription::Shape::Rectangle;
+                element.rectangle = wxRect2DDouble(DoubleAttribute(child, L"x", 0),
+                                                   DoubleAttribute(child, L"y", 0),
+                                                   DoubleAttribute(child, L"width", 0),
+                                                   DoubleAttribute(child, L"height", 0));
+            }
+            else if (child->GetName() == L"circle")
+            {
+                element.shape = MachineDescription::Shape::Circle;
+                element.radius = DoubleAttribute(child, L"radius", 0);
+            }
+            else if (child->GetName() == L"point")
+            {
+                element.shape = MachineDescription::Shape::Polygon;
+                element.points.push_back(wxPoint2DDouble(DoubleAttribute(child, L"x", 0),
+                                                         DoubleAttribute(child, L"y", 0)));
+            }
+        }
+
+        auto index = description->AddElement(element);
+        if (!element.id.empty())
+        {
+            ids[element.id] = index;
+        }
+    }
+
+    // Unknown ids leave the index at -1 and are skipped by Create
+    auto lookup = [&ids](wxXmlNode* node, const wxString& name) {
+        auto found = ids.find(node->GetAttribute(name, wxEmptyString).ToStdWstring());
+        return found != ids.end() ? found->second : -1;
+    };
+
+    for (auto& connection : connections)
+    {
+        connection.second.source = lookup(connection.first, L"source");
+        connection.second.sink = lookup(connection.first, L"sink");
+        description->AddConnection(connection.second);
+    }
+
+    for (auto node : belts)
+    {
+        MachineDescription::Belt belt;
+        belt.first = lookup(node, L"first");
+        belt.second = lookup(node, L"second");
+        description->AddBelt(belt);
+    }
+
+    return description;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file MachineLoader.h
+ * @author djmik
+ *
+ * Loads machine description XML files
+ */
+
+#ifndef CANADIANEXPERIENCE_MACHINELIB_MACHINELOADER_H
+#define CANADIANEXPERIENCE_MACHINELIB_MACHINELOADER_H
+
+class Machine;
+class MachineDescription;
+class wxXmlNode;
+class wxInputStream;
+
+/**
+ * Machine loader class
+ *
+ * Reads a machine description from an XML file and builds a Machine
+ * from it. The time spent parsing and constructing the last machine
+ * is kept so it can be profiled.
+ */
+class MachineLoader
+{
+private:
+    /// Time spent parsing the last file in milliseconds
+    double mParseTime = 0;
+
+    /// Time spent constructing the last machine in milliseconds
+    double mBuildTime = 0;
+
+    /// Message describing the last failure
+    std::wstring mError;
+
+    std::shared_ptr<MachineDescription> XmlMachine(wxXmlNode* root);
+
+public:
+    std::shared_ptr<MachineDescription> Parse(const std::wstring& filename);
+
+    std::shared_ptr<MachineDescription> Parse(wxInputStream& stream);
+
+    std::shared_ptr<Machine> Load(const std::wstring& filename, const std::wstring& resourcesDir);
+
+    /**
+     * Get the time spent parsing the last file
+     * @return Time in milliseconds
+     */
+    double GetParseTime() const { return mParseTime; }
+
+    /**
+     * Get the time spent constructing the last machine
+     * @return Time in milliseconds
+     */
+    double GetBuildTime() const { return mBuildTime; }
+
+    /**
+     * Get a description of the last failure
+     * @return Error message, empty if the last load succeeded
+     */
+    const std::wstring& GetError() const { return mError; }
+};
+
+#endif //CANADIANEXPERIENCE_MACHINELIB_MACHINELOADER_H
@@ -0,0 +1,356 @@
+/**
+ * @file MachineRegistry.cpp
+ * @author djmik
+ */
+
+#include "pch.h"
+#include <algorithm>
+#include <chrono>
+#include "MachineRegistry.h"
+#include "Machine.h"
+#include "Trace.h"
+
+/**
+ * Register a machine factory
+ *
+ * Registering a number that already exists replaces the factory
+ * and discards any machine built or being built by the old one. A
+ * build that is still running is set aside rather than waited for,
+ * and released by Poll once it finishes.
+ * @param number Machine number
+ * @param name Machine name
+ * @param creator Function that builds the machine
+ */
+void MachineRegistry::Register(int number, const std::wstring &name, Creator creator)
+{
+    mFactories[number] = Factory{name, creator};
+
+    auto pending = mPending.find(number);
+    if (pending != mPending.end())
+    {
+        mAbandoned.push_back(pending->second);
+        mPending.erase(pending);
+    }
+
+    mRequested.erase(number);
+    mCache.remove_if([number](const auto& entry) { return entry.first == number; });
+}
+
+/**
+ * Get the name of a registered machine
+ * @param number Machine number
+ * @return Name, or an empty string if the number is not registered
+ */
+std::wstring MachineRegistry::GetName(int number) const
+{
+    auto factory = mFactories.find(number);
+    return factory != mFactories.end() ? factory->second.name : std::wstring();
+}
+
+/**
+ * Get the function that builds a registered machine
+ * @param number Machine number
+ * @return Creator, or an empty function if the number is not registered
+ */
+MachineRegistry::Creator MachineRegistry::GetCreator(int number) const
+{
+    auto factory = mFactories.find(number);
+    return factory != mFactories.end() ? factory->second.creator : Creator();
+}
+
+/**
+ * Find a machine number by name
+ * @param name Machine name
+ * @return Machine number, or 0 if no machine has this name
+ */
+int MachineRegistry::Find(const std::wstring &name) const
+{
+    for (const auto& factory : mFactories)
+    {
+        if (factory.second.name == name)
+        {
+            return factory.first;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Get every registered machine number
+ * @return Machine numbers in increasing order
+ */
+std::vector<int> MachineRegistry::GetNumbers() const
+{
+    std::vector<int> numbers;
+    for (const auto& factory : mFactories)
+    {
+        numbers.push_back(factory.first);
+    }
+
+    return numbers;
+}
+
+/**
+ * Build a new machine, bypassing the cache
+ * @param number Machine number
+ * @param resourcesDir Directory holding images for components created
+ * @return machine pointer, or nullptr if the number is not registered
+ */
+std::shared_ptr<Machine> MachineRegistry::Create(int number, const std::wstring &resourcesDir) const
+{
+    auto factory = mFactories.find(number);
+    if (factory == mFactories.end())
+    {
+        return nullptr;
+    }
+
+    TRACE_SCOPE("build machine", "machine");
+    return factory->second.creator(resourcesDir);
+}
+
+/**
+ * Get a machine ready to run from time zero
+ *
+ * A machine in the cache is reset and reused. Otherwise a new machine
+ * is built and cached, evicting the least recently used machine if the
+ * cache is full.
+ *
+ * Each request counts once as a hit or a miss. Collecting a machine
+ * that BuildAsync started is part of that earlier request.
+ * @param number Machine number
+ * @param resourcesDir Directory holding images for components created
+ * @return machine pointer, or nullptr if the number is not registered
+ */
+std::shared_ptr<Machine> MachineRegistry::Get(int number, const std::wstring &resourcesDir)
+{
+    bool counted = mRequested.erase(number) > 0;
+
+    // Rather than build twice, wait for a build already under way
+    auto pending = mPending.find(number);
+    if (pending != mPending.end())
+    {
+        pending->second.wait();
+        Poll();
+    }
+
+    auto machine = Lookup(number);
+    if (machine != nullptr)
+    {
+        if (!counted)
+        {
+            mHits++;
+        }
+
+        machine->Reset();
+        return machine;
+    }
+
+    machine = Create(number, resourcesDir);
+    if (machine != nullptr)
+    {
+        if (!counted)
+        {
+            mMisses++;
+        }
+
+        Insert(number, machine);
+    }
+
+    return machine;
+}
+
+/**
+ * Get a machine from the cache without building it
+ *
+ * The machine becomes the most recently used. It is not reset.
+ * @param number Machine number
+ * @return machine pointer, or nullptr if the machine is not cached
+ */
+std::shared_ptr<Machine> MachineRegistry::GetCached(int number)
+{
+    auto machine = Lookup(number);
+    if (machine != nullptr)
+    {
+        mHits++;
+    }
+
+    return machine;
+}
+
+/**
+ * Find a cached machine and make it the most recently used
+ *
+ * Unlike GetCached, this is not counted as a request.
+ * @param number Machine number
+ * @return machine pointer, or nullptr if the machine is not cached
+ */
+std::shared_ptr<Machine> MachineRegistry::Lookup(int number)
+{
+    for (auto entry = mCache.begin(); entry != mCache.end(); ++entry)
+    {
+        if (entry->first == number)
+        {
+            mCache.splice(mCache.begin(), mCache, entry);
+            return mCache.front().second;
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * Is a built machine for this number in the cache?
+ * @param number Machine number
+ * @return true if cached
+ */
+bool MachineRegistry::IsCached(int number) const
+{
+    for (const auto& entry : mCache)
+    {
+        if (entry.first == number)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Start building a machine on a worker thread
+ *
+ * The finished machine is moved into the cache by Poll. If the machine
+ * is already being built, the existing handle is returned. The request
+ * counts as a miss now, not when Get later collects the machine.
+ * @param number Machine number
+ * @param resourcesDir Directory holding images for components created
+ * @return Handle to the machine being built. The handle is not valid
+ * if the number is not registered.
+ */
+MachineRegistry::Pending MachineRegistry::BuildAsync(int number, const std::wstring &resourcesDir)
+{
+    if (!IsRegistered(number))
+    {
+        return Pending();
+    }
+
+    if (mRequested.insert(number).second)
+    {
+        mMisses++;
+    }
+
+    StartBuild(number, resourcesDir);
+    return mPending[number];
+}
+
+/**
+ * Build a machine we expect to show soon in the background
+ *
+ * Does nothing if the machine is already cached or being built. This
+ * is not a request, so it counts as neither a hit nor a miss.
+ * @param number Machine number
+ * @param resourcesDir Directory holding images for components created
+ */
+void MachineRegistry::Prewarm(int number, const std::wstring &resourcesDir)
+{
+    if (!IsCached(number) && IsRegistered(number))
+    {
+        StartBuild(number, resourcesDir);
+    }
+}
+
+/**
+ * Run a registered factory on a worker thread unless it is already running
+ * @param number Registered machine number
+ * @param resourcesDir Directory holding images for components created
+ */
+void MachineRegistry::StartBuild(int number, const std::wstring &resourcesDir)
+{
+    if (mPending.find(number) != mPending.end())
+    {
+        return;
+    }
+
+    // The worker gets its own copies of everything it uses
+    auto creator = GetCreator(number);
+    mPending[number] = std::async(std::launch::async, [creator, resourcesDir]() {
+        TRACE_SCOPE("build machine", "machine");
+        return creator(resourcesDir);
+    }).share();
+}
+
+/**
+ * Move machines finished on worker threads into the cache
+ *
+ * A build that failed is logged and dropped so it can be tried again,
+ * which Get does on the calling thread. Builds set
+ * aside by Register are released once they finish.
+ */
+void MachineRegistry::Poll()
+{
+    mAbandoned.erase(std::remove_if(mAbandoned.begin(), mAbandoned.end(), [](const Pending& pending) {
+        return pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }), mAbandoned.end());
+
+    for (auto pending = mPending.begin(); pending != mPending.end(); )
+    {
+        if (pending->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            ++pending;
+            continue;
+        }
+
+        try
+        {
+            auto machine = pending->second.get();
+            if (machine != nullptr)
+            {
+                Insert(pending->first, machine);
+            }
+        }
+        catch (const std::exception& exception)
+        {
+            wxLogWarning(L"Building machine %d failed: %s", pending->first, exception.what());
+        }
+        catch (...)
+        {
+            wxLogWarning(L"Building machine %d failed", pending->first);
+        }
+
+        pending = mPending.erase(pending);
+    }
+}
+
+/**
+ * Put a built machine into the cache as the most recently used
+ * @param number Machine number
+ * @param machine Machine that was built for this number
+ */
+void MachineRegistry::Insert(int number, std::shared_ptr<Machine> machine)
+{
+    mCache.remove_if([number](const auto& entry) { return entry.first == number; });
+    mCache.emplace_front(number, machine);
+    Trim();
+}
+
+/**
+ * Set the maximum number of built machines kept
+ * @param capacity New capacity (at least 1)
+ */
+void MachineRegistry::SetCapacity(size_t capacity)
+{
+    mCapacity = capacity > 0 ? capacity : 1;
+    Trim();
+}
+
+/**
+ * Evict the least recently used machines beyond the capacity
+ */
+void MachineRegistry::Trim()
+{
+    while (mCache.size() > mCapacity)
+    {
+        mCache.pop_back();
+    }
+}
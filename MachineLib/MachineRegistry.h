@@ -0,0 +1,155 @@
+/**
+ * @file MachineRegistry.h
+ * @author djmik
+ *
+ * Registry of machine factories with a cache of built machines
+ */
+
+#ifndef CANADIANEXPERIENCE_MACHINELIB_MACHINEREGISTRY_H
+#define CANADIANEXPERIENCE_MACHINELIB_MACHINEREGISTRY_H
+
+#include <functional>
+#include <future>
+#include <list>
+#include <map>
+#include <set>
+
+class Machine;
+
+/**
+ * Machine registry class
+ *
+ * Factories register under a machine number and a name. Machines that
+ * have been built are kept in a bounded least recently used cache, so
+ * switching back to a recent machine resets it instead of rebuilding it.
+ *
+ * Machines can also be built on a worker thread. The registry itself is
+ * only used from the thread that owns it; workers only run the factory.
+ */
+class MachineRegistry
+{
+public:
+    /// Function that builds a machine from a resources directory
+    typedef std::function<std::shared_ptr<Machine>(const std::wstring& resourcesDir)> Creator;
+
+    /// Handle to a machine being built on a worker thread
+    typedef std::shared_future<std::shared_ptr<Machine>> Pending;
+
+private:
+    /**
+     * A registered factory
+     */
+    struct Factory
+    {
+        /// Name of the machine
+        std::wstring name;
+
+        /// Function that builds the machine
+        Creator creator;
+    };
+
+    /// Registered factories by machine number
+    std::map<int, Factory> mFactories;
+
+    /// Built machines by number, most recently used first
+    std::list<std::pair<int, std::shared_ptr<Machine>>> mCache;
+
+    /// Machines being built on worker threads by number
+    std::map<int, Pending> mPending;
+
+    /// Builds whose factory was replaced while they ran, kept until
+    /// they finish since releasing a future waits for its build
+    std::vector<Pending> mAbandoned;
+
+    /// Maximum number of built machines to keep
+    size_t mCapacity = 4;
+
+    /// Number of requests satisfied from the cache
+    int mHits = 0;
+
+    /// Number of requests that had to build a machine
+    int mMisses = 0;
+
+    /// Machines requested with BuildAsync whose miss is already counted
+    std::set<int> mRequested;
+
+    std::shared_ptr<Machine> Lookup(int number);
+
+    void StartBuild(int number, const std::wstring& resourcesDir);
+
+    void Trim();
+
+public:
+    void Register(int number, const std::wstring& name, Creator creator);
+
+    /**
+     * Is a machine number registered?
+     * @param number Machine number
+     * @return true if a factory exists for this number
+     */
+    bool IsRegistered(int number) const { return mFactories.find(number) != mFactories.end(); }
+
+    std::wstring GetName(int number) const;
+
+    Creator GetCreator(int number) const;
+
+    int Find(const std::wstring& name) const;
+
+    std::vector<int> GetNumbers() const;
+
+    std::shared_ptr<Machine> Create(int number, const std::wstring& resourcesDir) const;
+
+    std::shared_ptr<Machine> Get(int number, const std::wstring& resourcesDir);
+
+    std::shared_ptr<Machine> GetCached(int number);
+
+    bool IsCached(int number) const;
+
+    Pending BuildAsync(int number, const std::wstring& resourcesDir);
+
+    void Prewarm(int number, const std::wstring& resourcesDir);
+
+    /**
+     * Is a machine being built on a worker thread?
+     * @param number Machine number
+     * @return true if a build is in progress
+     */
+    bool IsPending(int number) const { return mPending.find(number) != mPending.end(); }
+
+    void Poll();
+
+    void Insert(int number, std::shared_ptr<Machine> machine);
+
+    void SetCapacity(size_t capacity);
+
+    /**
+     * Get the maximum number of built machines kept
+     * @return Cache capacity
+     */
+    size_t GetCapacity() const { return mCapacity; }
+
+    /**
+     * Get the number of built machines currently kept
+     * @return Cached machine count
+     */
+    size_t GetCachedCount() const { return mCache.size(); }
+
+    /**
+     * Get the number of requests satisfied from the cache
+     * @return Cache hits
+     */
+    int GetHits() const { return mHits; }
+
+    /**
+     * Get the number of requests that built a machine
+     * @return Cache misses
+     */
+    int GetMisses() const { return mMisses; }
+
+    /**
+     * Release every built machine
+     */
+    void Clear() { mCache.clear(); }
+};
+
+#endif //CANADIANEXPERIENCE_MACHINELIB_MACHINEREGISTRY_H
@@ -4,10 +4,39 @@
  */
 
 #include "pch.h"
+#include <wx/dir.h>
+#include <wx/filename.h>
 #include "Machine.h"
 #include "MachineSystem.h"
 #include "Machine1Factory.h"
 #include "Machine2Factory.h"
+#include "StressFactory.h"
+#include "MachineLoader.h"
+#include "MachineBinary.h"
+#include "AssetBundle.h"
+#include "ImageCache.h"
+#include "TextureAtlas.h"
+#include "Profiler.h"
+#include "Trace.h"
+#include "DebugDraw.h"
+#include <b2_world.h>
+#include <b2_body.h>
+
+/// Directory within resources that contains machine description files
+const std::wstring MachinesDirectory = L"/machines";
+
+/// Directory within resources that contains the images
+const std::wstring ImagesDirectory = L"/images";
+
+/// Bundle of every image, built by the AssetBundler tool
+const std::wstring ImagesBundle = L"/images.bundle";
+
+/// Milliseconds after the playhead last jumped before it is
+/// considered settled and drawn at best quality
+const long SettleTime = 200;
+
+/// Body counts of the stress machines, each registered under its count
+const int StressMachines[] = {100, 1000, 10000, 100000};
 
 /**
  * Constructor
@@ -18,9 +47,115 @@
  */
 MachineSystem::MachineSystem(const std::wstring &resourcesDir) : mResourcesDir(resourcesDir)
 {
+    MountImages();
+    RegisterMachines();
     SetMachineNumber(1);
 }
 
+/**
+ * Read images from the resources image bundle, if one was built
+ *
+ * Without a bundle every image is read from its own file.
+ */
+void MachineSystem::MountImages()
+{
+    auto filename = mResourcesDir + ImagesBundle;
+    if (!wxFileExists(filename))
+    {
+        return;
+    }
+
+    auto bundle = std::make_shared<AssetBundle>();
+    if (bundle->Open(filename))
+    {
+        ImageCache::Mount(mResourcesDir + ImagesDirectory, bundle);
+    }
+}
+
+/**
+ * Register the machines that can be selected
+ *
+ * Machine files machines/machine<number>.xml and machine<number>.bin
+ * override or add to the machines built into the code, so layouts can
+ * be changed without rebuilding. A compiled file is preferred over a
+ * description of the same machine.
+ */
+void MachineSystem::RegisterMachines()
+{
+    mRegistry.Register(1, L"Machine 1", Machine1Factory::Create);
+    mRegistry.Register(2, L"Machine 2", Machine2Factory::Create);
+
+    // Stress machines are numbered by about how many bodies they have
+    for (int bodies : StressMachines)
+    {
+        mRegistry.Register(bodies, L"Stress " + std::to_wstring(bodies), [bodies](const std::wstring& resourcesDir) {
+            return StressFactory::Create(resourcesDir, StressFactory::ForBodies(bodies));
+        });
+    }
+
+    auto machinesDir = mResourcesDir + MachinesDirectory;
+    if (!wxDir::Exists(machinesDir))
+    {
+        return;
+    }
+
+    wxDir dir(machinesDir);
+    wxString file;
+    for (auto spec : {L"machine*.xml", L"machine*.bin"})
+    {
+        for (bool found = dir.GetFirst(&file, spec, wxDIR_FILES); found; found = dir.GetNext(&file))
+        {
+            RegisterFile(machinesDir + L"/" + file.ToStdWstring());
+        }
+    }
+}
+
+/**
+ * Register a machine file under the number in its name
+ *
+ * If the file cannot be loaded, whatever was registered under that
+ * number before is built instead. How long each load took is logged
+ * as a verbose message.
+ * @param filename Path to machine<number>.xml or machine<number>.bin
+ */
+void MachineSystem::RegisterFile(const std::wstring &filename)
+{
+    wxFileName name(filename);
+    long number;
+    if (!name.GetName().Mid(7).ToLong(&number))
+    {
+        return;
+    }
+
+    auto fallback = mRegistry.GetCreator(number);
+    bool compiled = name.GetExt() == L"bin";
+    mRegistry.Register(number, name.GetName().ToStdWstring(),
+        [filename, fallback, compiled](const std::wstring& resourcesDir) {
+            std::shared_ptr<Machine> machine;
+            if (compiled)
+            {
+                MachineBinary binary;
+                machine = binary.Load(filename, resourcesDir);
+                wxLogVerbose(L"%s: read %.1f ms, build %.1f ms %s", filename,
+                             binary.GetReadTime(), binary.GetBuildTime(), binary.GetError());
+            }
+            else
+            {
+                MachineLoader loader;
+                machine = loader.Load(filename, resourcesDir);
+                wxLogVerbose(L"%s: parse %.1f ms, build %.1f ms %s", filename,
+                             loader.GetParseTime(), loader.GetBuildTime(), loader.GetError());
+            }
+
+            if (machine == nullptr && fallback)
+            {
+                machine = fallback(resourcesDir);
+            }
+
+            return machine;
+        });
+}
+
 
 /**
  * Draws the machine
@@ -28,38 +163,261 @@ MachineSystem::MachineSystem(const std::wstring &resourcesDir) : mResourcesDir(r
  */
 void MachineSystem::DrawMachine(std::shared_ptr<wxGraphicsContext> graphics)
 {
+    TRACE_SCOPE("draw machine", "draw");
+    UpdatePending();
+
+    auto start = Profiler::Now();
+    auto now = std::max(1L, mClock.Time());
+    mFrameInterval = mLastDraw > 0 ? now - mLastDraw : 0;
+    mLastDraw = now;
+
     graphics->PushState();
     graphics->Translate(mLocation.x, mLocation.y);
     graphics->Scale(mPixelsPerCentimeter, -mPixelsPerCentimeter);
-    graphics->SetInterpolationQuality(wxINTERPOLATION_BEST);
+
+    mDrawnFast = mQuality == Quality::Fast || (mQuality == Quality::Adaptive && IsScrubbing());
+    graphics->SetInterpolationQuality(mDrawnFast ? wxINTERPOLATION_FAST : wxINTERPOLATION_BEST);
     if (mMachine) {
         mMachine->Draw(graphics);
     }
+
+    if (mFlag & PhysicsFlag) {
+        DrawPhysics(graphics);
+    }
     graphics->PopState();
+    mDrawTime = Profiler::Since(start);
+
+    if (mFlag & OverlayFlag) {
+        DrawOverlay(graphics);
+    }
+
+    // Every bitmap the machine needs exists after its first draw
+    if (mFirstDraw)
+    {
+        mFirstDraw = false;
+        ReleaseImages();
+    }
+}
+
+/**
+ * Draw the physics shapes over the machine as Box2D sees them
+ * @param graphics Graphics context in machine coordinates
+ */
+void MachineSystem::DrawPhysics(std::shared_ptr<wxGraphicsContext> graphics)
+{
+    if (mMachine == nullptr) {
+        return;
+    }
+
+    DebugDraw debugDraw(graphics);
+    debugDraw.SetFlags(b2Draw::e_shapeBit | b2Draw::e_centerOfMassBit);
+    debugDraw.SetLineWidth(1 / mPixelsPerCentimeter);
+
+    auto world = mMachine->GetWorld();
+    world->SetDebugDraw(&debugDraw);
+    world->DebugDraw();
+    world->SetDebugDraw(nullptr);
+}
+
+/**
+ * Draw the performance overlay in the top left corner
+ *
+ * Shows frame, update and draw times, what the physics world holds
+ * and how well the caches are doing.
+ * @param graphics Graphics context
+ */
+void MachineSystem::DrawOverlay(std::shared_ptr<wxGraphicsContext> graphics)
+{
+    std::vector<wxString> lines;
+    lines.push_back(wxString::Format(L"Frame %d  interval %.1f ms  draw %.2f ms  update %.2f ms",
+                                     mFrame, mFrameInterval, mDrawTime, mUpdateTime));
+
+    if (mMachine) {
+        auto world = mMachine->GetWorld();
+        int awake = 0;
+        for (auto body = world->GetBodyList(); body != nullptr; body = body->GetNext()) {
+            awake += body->IsAwake() && body->GetType() != b2_staticBody;
+        }
+
+        lines.push_back(wxString::Format(L"Physics step %.2f ms  bodies %d (%d awake)  contacts %d",
+                                         world->GetProfile().step, world->GetBodyCount(), awake,
+                                         world->GetContactCount()));
+        lines.push_back(wxString::Format(L"Components %lu", (unsigned long)mMachine->GetComponentCount()));
+    }
+
+    auto imageRequests = ImageCache::GetHits() + ImageCache::GetMisses();
+    lines.push_back(wxString::Format(L"Machine cache %d hits %d misses  image cache %.0f%% of %lu hits",
+                                     mRegistry.GetHits(), mRegistry.GetMisses(),
+                                     imageRequests > 0 ? 100.0 * ImageCache::GetHits() / imageRequests : 0.0,
+                                     (unsigned long)imageRequests));
+    lines.push_back(wxString::Format(L"Image memory %lu KB  atlas pages %lu",
+                                     (unsigned long)((ImageCache::GetMemory() + TextureAtlas::GetMemory()) / 1024),
+                                     (unsigned long)TextureAtlas::GetPageCount()));
+
+    if (!mOverlayFont.IsOk())
+    {
+        mOverlayFont = wxFont(wxSize(0, 14), wxFONTFAMILY_TELETYPE, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_NORMAL);
+    }
+    graphics->SetFont(mOverlayFont, *wxWHITE);
+
+    double width = 0, height = 0;
+    for (const auto& line : lines) {
+        double w, h;
+        graphics->GetTextExtent(line, &w, &h);
+        width = std::max(width, w);
+        height = h;
+    }
+
+    const double margin = 6;
+    graphics->SetPen(*wxTRANSPARENT_PEN);
+    graphics->SetBrush(wxBrush(wxColour(0, 0, 0, 160)));
+    graphics->DrawRectangle(0, 0, width + margin * 2, height * lines.size() + margin * 2);
+
+    for (size_t i = 0; i < lines.size(); i++) {
+        graphics->DrawText(lines[i], margin, margin + height * i);
+    }
+}
+
+/**
+ * Is the playhead being scrubbed?
+ *
+ * Playback advances one frame at a time. Any other change of frame
+ * is a jump, and the playhead is scrubbing until it has gone a short
+ * time without one.
+ * @return true if the playhead jumped recently
+ */
+bool MachineSystem::IsScrubbing()
+{
+    return mLastJump > 0 && mClock.Time() - mLastJump < SettleTime;
+}
+
+/**
+ * Free decoded images that were only needed to create bitmaps, and
+ * the atlas's references to masked bitmaps
+ *
+ * The memory in use before and after is kept so it can be reported.
+ */
+void MachineSystem::ReleaseImages()
+{
+    mImageMemoryBefore = ImageCache::GetMemory() + TextureAtlas::GetMemory();
+    if (ImageCache::GetPolicy() == ImageCache::Policy::Release)
+    {
+        ImageCache::Trim();
+    }
+
+    // Every polygon now holds the masked bitmap it draws
+    TextureAtlas::Trim();
+    mImageMemoryAfter = ImageCache::GetMemory() + TextureAtlas::GetMemory();
+
+    wxLogVerbose(L"Machine %d decoded images: %zu KB before release, %zu KB after",
+                 mNumber, mImageMemoryBefore / 1024, mImageMemoryAfter / 1024);
 }
 
 /**
  * Sets the machine number
+ *
+ * Recently used machines are reset and reused rather than rebuilt.
+ * A machine that is not cached is built on a worker thread while the
+ * current machine stays on screen; it replaces it once it is ready.
  * @param machine new machine number
  */
 void MachineSystem::SetMachineNumber(int machine)
 {
-    mMachine.reset();
-    switch(machine) {
-        case (1):
-            Machine1Factory machine1Factory;
-            mMachine = machine1Factory.Create(mResourcesDir);
-            mMachine->SetSystem(this);
-            break;
-        case (2):
-            Machine2Factory machine2Factory;
-            mMachine = machine2Factory.Create(mResourcesDir);
-            mMachine->SetSystem(this);
-            break;
-        default:
-            break;
-    }
     mNumber = machine;
+    mPendingNumber = 0;
+
+    if (mMachine == nullptr || !mAsynchronous || mRegistry.IsCached(machine) ||
+        !mRegistry.IsRegistered(machine))
+    {
+        mFrame = 0;
+        Activate(mRegistry.Get(machine, mResourcesDir));
+        return;
+    }
+
+    mRegistry.BuildAsync(machine, mResourcesDir);
+    mPendingNumber = machine;
+}
+
+/**
+ * Start building a machine in the background before it is selected
+ * @param number Machine number
+ */
+void MachineSystem::PrewarmMachine(int number)
+{
+    mRegistry.Prewarm(number, mResourcesDir);
+}
+
+/**
+ * Make a machine the one being drawn
+ *
+ * The machine is brought up to the current frame, so a machine that
+ * finished building late starts at the same time as the one it replaces.
+ * @param machine Machine to show
+ */
+void MachineSystem::Activate(std::shared_ptr<Machine> machine)
+{
+    // Only the machine being shown is profiled
+    if (mMachine) {
+        mMachine->SetProfiler(nullptr);
+    }
+
+    mMachine = machine;
+    if (mMachine) {
+        mMachine->SetSystem(this);
+        mMachine->SetProfiler(mProfiler);
+    }
+
+    if (mProfiler) {
+        mProfiler->Clear();
+    }
+    mFirstDraw = true;
+
+    // Catching up is not the user moving the playhead
+    auto frame = mFrame;
+    auto lastJump = mLastJump;
+    mFrame = 0;
+    SetMachineFrame(frame);
+    mLastJump = lastJump;
+}
+
+/**
+ * Turn recording of update and draw times on or off
+ *
+ * Statistics start over each time profiling is turned on and
+ * whenever a different machine is shown.
+ * @param profiling true to record times
+ */
+void MachineSystem::SetProfiling(bool profiling)
+{
+    if (profiling == (mProfiler != nullptr))
+    {
+        return;
+    }
+
+    mProfiler = profiling ? std::make_shared<Profiler>() : nullptr;
+    if (mMachine) {
+        mMachine->SetProfiler(mProfiler);
+    }
+}
+
+/**
+ * Switch to the selected machine if its background build has finished
+ */
+void MachineSystem::UpdatePending()
+{
+    if (mPendingNumber == 0)
+    {
+        return;
+    }
+
+    mRegistry.Poll();
+    if (mRegistry.IsCached(mPendingNumber) || !mRegistry.IsPending(mPendingNumber))
+    {
+        // A failed build falls back to building synchronously
+        auto number = mPendingNumber;
+        mPendingNumber = 0;
+        Activate(mRegistry.Get(number, mResourcesDir));
+    }
 }
 
 /**
@@ -68,6 +426,16 @@ void MachineSystem::SetMachineNumber(int machine)
  */
 void MachineSystem::SetMachineFrame(int frame)
 {
+    TRACE_SCOPE("set frame", "frame");
+    UpdatePending();
+    auto start = Profiler::Now();
+
+    if (frame < mFrame || frame > mFrame + 1)
+    {
+        // Never zero, which means no jump yet
+        mLastJump = std::max(1L, mClock.Time());
+    }
+
     if (mMachine) {
         if(frame < mFrame)
         {
@@ -85,6 +453,8 @@ void MachineSystem::SetMachineFrame(int frame)
         mFrame = frame;
     }
 
+    mUpdateTime = Profiler::Since(start);
+
     // May need more than these, but you'll figure that out...
 
 
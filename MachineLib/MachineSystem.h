@@ -8,9 +8,12 @@
 #ifndef CANADIANEXPERIENCE_MACHINELIB_MACHINESYSTEM_H
 #define CANADIANEXPERIENCE_MACHINELIB_MACHINESYSTEM_H
 
+#include <wx/stopwatch.h>
 #include "IMachineSystem.h"
+#include "MachineRegistry.h"
 
 class Machine;
+class Profiler;
 
 /**
  * Machine system class
@@ -20,6 +23,22 @@ class Machine;
  */
 class MachineSystem : public IMachineSystem
 {
+public:
+    /// How image interpolation quality is chosen when drawing
+    enum class Quality {
+        /// Fast while the playhead is being scrubbed, best once it settles
+        Adaptive,
+        /// Always fast
+        Fast,
+        /// Always best, such as when exporting frames
+        Best };
+
+    /// SetFlag bit that shows the performance overlay
+    static const int OverlayFlag = 1;
+
+    /// SetFlag bit that draws the physics shapes as Box2D sees them
+    static const int PhysicsFlag = 2;
+
 private:
     /// location of machine
     wxPoint mLocation = wxPoint(0,0);
@@ -37,7 +56,7 @@ private:
     double mFrameRate = 30;
 
     /// Current flag set
-    int mFlag;
+    int mFlag = 0;
 
     /// resource directory
     std::wstring mResourcesDir;
@@ -48,6 +67,70 @@ private:
     /// How many pixels there are for each CM
     double mPixelsPerCentimeter = 1.5;
 
+    /// Machines that can be selected by number
+    MachineRegistry mRegistry;
+
+    /// Number of a machine being built on a worker thread, 0 if none
+    int mPendingNumber = 0;
+
+    /// Are machines that are not cached built in the background?
+    bool mAsynchronous = true;
+
+    /// How interpolation quality is chosen
+    Quality mQuality = Quality::Adaptive;
+
+    /// Clock used to tell when the playhead has settled
+    wxStopWatch mClock;
+
+    /// Clock time in milliseconds the playhead last jumped
+    long mLastJump = 0;
+
+    /// Set if the last draw used fast interpolation
+    bool mDrawnFast = false;
+
+    /// Set when a machine becomes active and has not yet been drawn
+    bool mFirstDraw = false;
+
+    /// Bytes of decoded image data before the last machine's first draw
+    size_t mImageMemoryBefore = 0;
+
+    /// Bytes of decoded image data left after the last machine's first draw
+    size_t mImageMemoryAfter = 0;
+
+    /// Profiler attached to the machine, null when not profiling
+    std::shared_ptr<Profiler> mProfiler;
+
+    /// Milliseconds the last SetMachineFrame took
+    double mUpdateTime = 0;
+
+    /// Milliseconds the last machine draw took
+    double mDrawTime = 0;
+
+    /// Milliseconds between the last two draws
+    double mFrameInterval = 0;
+
+    /// When the machine was last drawn, 0 if never
+    long mLastDraw = 0;
+
+    /// Font for the statistics overlay, created on first use
+    wxFont mOverlayFont;
+
+    void DrawPhysics(std::shared_ptr<wxGraphicsContext> graphics);
+
+    void DrawOverlay(std::shared_ptr<wxGraphicsContext> graphics);
+
+    void MountImages();
+
+    void RegisterMachines();
+
+    void RegisterFile(const std::wstring& filename);
+
+    void Activate(std::shared_ptr<Machine> machine);
+
+    void UpdatePending();
+
+    void ReleaseImages();
+
 public:
 
     MachineSystem(const std::wstring& resourcesDir);
@@ -89,10 +172,79 @@ public:
     double GetMachineTime() override { return mFrame/mFrameRate; }
 
     /**
-     * Sets flags of the machine, if any (flags not implemented)
+     * Sets flags of the machine
+     *
+     * OverlayFlag shows the performance overlay and PhysicsFlag draws
+     * the physics shapes over the machine.
      * @param flag value of flag to set
      */
     void SetFlag(int flag) override { mFlag = flag; }
+
+    /**
+     * Set whether machines are built in the background
+     *
+     * When off, SetMachineNumber builds the machine before returning.
+     * @param asynchronous true to build on a worker thread
+     */
+    void SetAsynchronous(bool asynchronous) { mAsynchronous = asynchronous; }
+
+    void PrewarmMachine(int number);
+
+    /**
+     * Is the selected machine built and showing?
+     * @return false while the selected machine is still being built
+     */
+    bool IsMachineReady() const { return mPendingNumber == 0; }
+
+    /**
+     * Set how interpolation quality is chosen
+     * @param quality New quality policy
+     */
+    void SetQuality(Quality quality) { mQuality = quality; }
+
+    /**
+     * Get how interpolation quality is chosen
+     * @return Quality policy
+     */
+    Quality GetQuality() const { return mQuality; }
+
+    bool IsScrubbing();
+
+    /**
+     * Should the machine be drawn again at best quality?
+     *
+     * True once the playhead settles after a draw at fast quality.
+     * @return true if a redraw would improve the image
+     */
+    bool NeedsRefinement() { return mDrawnFast && !IsScrubbing(); }
+
+    /**
+     * Get the decoded image memory in use when the current machine
+     * was first drawn, before images were released
+     * @return Bytes of pixel data
+     */
+    size_t GetImageMemoryBefore() const { return mImageMemoryBefore; }
+
+    /**
+     * Get the decoded image memory still in use once the current
+     * machine was drawn and its images released
+     * @return Bytes of pixel data
+     */
+    size_t GetImageMemoryAfter() const { return mImageMemoryAfter; }
+
+    void SetProfiling(bool profiling);
+
+    /**
+     * Get the profiler recording the current machine
+     * @return Profiler, or nullptr when not profiling
+     */
+    std::shared_ptr<Profiler> GetProfiler() { return mProfiler; }
+
+    /**
+     * Get the registry of machines that can be selected
+     * @return Machine registry
+     */
+    MachineRegistry& GetRegistry() { return mRegistry; }
 };
 
 #endif //CANADIANEXPERIENCE_MACHINELIB_MACHINESYSTEM_H
@@ -6,6 +6,7 @@
 #include "pch.h"
 #include "PhysicsPolygon.h"
 #include "Consts.h"
+#include "ShapeCache.h"
 #include <b2_polygon_shape.h>
 #include <b2_circle_shape.h>
 #include <b2_fixture.h>
@@ -32,59 +33,132 @@ void cse335::PhysicsPolygon::Draw(std::shared_ptr<wxGraphicsContext> graphics)
 
 /**
  * Install this component into the physics system world.
+ *
+ * A static polygon given a compound body becomes a fixture of that
+ * body, placed where the polygon would have been, instead of a body
+ * of its own. It still draws on its own, but can no longer be moved.
  * @param world Physics system world
+ * @param compound Shared static body, or nullptr for a body of its own
  */
-void cse335::PhysicsPolygon::InstallPhysics(std::shared_ptr<b2World> world)
+void cse335::PhysicsPolygon::InstallPhysics(std::shared_ptr<b2World> world, b2Body* compound)
 {
+    mCompound = compound != nullptr && mType == b2_staticBody;
+
     // Create the physics system body we will need for any
     // item in the physics space
-    b2BodyDef bodyDefinition;
-    bodyDefinition.type = mType;
-    mBody = world->CreateBody(&bodyDefinition);
+    if(mCompound)
+    {
+        mBody = compound;
+    }
+    else
+    {
+        b2BodyDef bodyDefinition;
+        bodyDefinition.type = mType;
+        mBody = world->CreateBody(&bodyDefinition);
+    }
+
+    // Identical polygons share a shape computed once
+    if(mShape == nullptr)
+    {
+        if(IsCircle())
+        {
+            mShape = ShapeCache::Circle(Radius());
+        }
+        else if(mShapeVertices.empty())
+        {
+            mShape = ShapeCache::Polygon(std::vector<wxPoint2DDouble>(begin(), end()));
+        }
+        else
+        {
+            mShape = ShapeCache::Polygon(mShapeVertices);
+        }
+    }
 
     b2FixtureDef fixtureDef;
+    fixtureDef.shape = mShape.get();
+    fixtureDef.density = mDensity;
+    fixtureDef.friction = mFriction;
+    fixtureDef.restitution = mRestitution;
+
+    if(mCompound)
+    {
+        InstallCompound(fixtureDef);
+        return;
+    }
+
+    mBody->CreateFixture(&fixtureDef);
+
+    mBody->SetTransform(b2Vec2(mInitialPosition.m_x / Consts::MtoCM,
+                               mInitialPosition.m_y / Consts::MtoCM), mInitialRotation);
+
+}
+
+/**
+ * Add this polygon as a fixture of the compound body
+ *
+ * The shared shape is moved to the polygon's position and rotation,
+ * since the compound body itself sits at the origin.
+ * @param fixtureDef Fixture definition using the shared shape
+ */
+void cse335::PhysicsPolygon::InstallCompound(b2FixtureDef& fixtureDef)
+{
+    b2Transform transform(b2Vec2(mInitialPosition.m_x / Consts::MtoCM, mInitialPosition.m_y / Consts::MtoCM),
+                          b2Rot(mInitialRotation));
 
-    // These must be in the same scope as fixtureDef:
     b2CircleShape circle;
     b2PolygonShape poly;
-
-    if(IsCircle())
+    if(mShape->GetType() == b2Shape::e_circle)
     {
-        circle.m_radius = Radius() / Consts::MtoCM - 0.005;
+        circle = *static_cast<const b2CircleShape*>(mShape.get());
+        circle.m_p = b2Mul(transform, circle.m_p);
         fixtureDef.shape = &circle;
     }
     else
     {
-        // Determine the maximum values in each dimension
-        auto boundingBox = Polygon::BoundingBox();
-
-        // Box2D adds a 0.5cm "skin" around objects. This shrinks the
-        // representation in that system to reflect that extra skin in the size
-        auto size = wxPoint2DDouble(boundingBox.m_width/2, boundingBox.m_height/2);
-        auto center = boundingBox.GetCentre();
-        auto scale = (size - wxPoint2DDouble(0.95, 0.95)) / size;
-
-        std::vector<b2Vec2> vertices;
-        for(auto v : *this)
+        auto shape = static_cast<const b2PolygonShape*>(mShape.get());
+        b2Vec2 vertices[b2_maxPolygonVertices];
+        for(int i = 0; i < shape->m_count; i++)
         {
-            auto scaled = ((v - center) * scale) + center;
-
-            vertices.push_back(b2Vec2(scaled.m_x / Consts::MtoCM, scaled.m_y / Consts::MtoCM));
+            vertices[i] = b2Mul(transform, shape->m_vertices[i]);
         }
 
-        poly.Set(&vertices[0], vertices.size());
+        poly.Set(vertices, shape->m_count);
         fixtureDef.shape = &poly;
     }
 
-    fixtureDef.density = mDensity;
-    fixtureDef.friction = mFriction;
-    fixtureDef.restitution = mRestitution;
-
     mBody->CreateFixture(&fixtureDef);
+}
 
-    mBody->SetTransform(b2Vec2(mInitialPosition.m_x / Consts::MtoCM,
-                               mInitialPosition.m_y / Consts::MtoCM), mInitialRotation);
+/**
+ * Compute the physics shape vertices for a polygon
+ *
+ * Box2D adds a 0.5cm "skin" around objects. This shrinks the
+ * representation in that system to reflect that extra skin in the size.
+ * @param points Polygon points in centimeters
+ * @return Shape vertices in meters
+ */
+std::vector<b2Vec2> cse335::PhysicsPolygon::ComputeShapeVertices(const std::vector<wxPoint2DDouble>& points)
+{
+    // Determine the maximum values in each dimension
+    wxRect2DDouble boundingBox(points[0].m_x, points[0].m_y, 0, 0);
+    for(auto v : points)
+    {
+        boundingBox.Union(v);
+    }
 
+    auto size = wxPoint2DDouble(boundingBox.m_width/2, boundingBox.m_height/2);
+    auto center = boundingBox.GetCentre();
+    auto scale = (size - wxPoint2DDouble(0.95, 0.95)) / size;
+
+    std::vector<b2Vec2> vertices;
+    for(auto v : points)
+    {
+        auto scaled = ((v - center) * scale) + center;
+
+        vertices.push_back(b2Vec2(scaled.m_x / Consts::MtoCM, scaled.m_y / Consts::MtoCM));
+    }
+
+    return vertices;
 }
 
 /**
@@ -93,7 +167,7 @@ void cse335::PhysicsPolygon::InstallPhysics(std::shared_ptr<b2World> world)
  */
 wxPoint2DDouble cse335::PhysicsPolygon::GetPosition()
 {
-    if(mBody != nullptr)
+    if(mBody != nullptr && !mCompound)
     {
         // Once installed in the physics system, we us
         // the current position from that system, converting
@@ -112,12 +186,19 @@ wxPoint2DDouble cse335::PhysicsPolygon::GetPosition()
 /**
  * Set the component rotation (current)
  *
- * Rotation is in turns, not radians or degrees
+ * Rotation is in turns, not radians or degrees. A polygon merged
+ * into a compound static body does not rotate, since its fixture
+ * is fixed in that body and drawing would no longer match it.
  *
  * @param rotation Rotation in turns
  */
 void cse335::PhysicsPolygon::SetRotation(double rotation)
 {
+    if(mCompound)
+    {
+        return;
+    }
+
     if(mBody != nullptr)
     {
         mBody->SetTransform(mBody->GetPosition(), rotation * M_PI * 2);
@@ -136,7 +217,7 @@ void cse335::PhysicsPolygon::SetRotation(double rotation)
  */
 double cse335::PhysicsPolygon::GetRotation()
 {
-    if(mBody != nullptr)
+    if(mBody != nullptr && !mCompound)
     {
         auto rotation = mBody->GetAngle();
         return rotation / (M_PI * 2);
@@ -190,7 +271,7 @@ void cse335::PhysicsPolygon::SetPhysics(double density, double friction, double
  */
 void cse335::PhysicsPolygon::SetAngularVelocity(double speed)
 {
-    if(mBody != nullptr)
+    if(mBody != nullptr && !mCompound)
     {
         mBody->SetAngularVelocity(speed * M_PI * 2);
     }
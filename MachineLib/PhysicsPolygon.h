@@ -11,6 +11,9 @@
  * Version history:
  * 1.00 Initial version for FS23 project 2
  * 1.01 Revised to work prior to physics installation
+ * 1.02 Physics vertices can be supplied precomputed
+ * 1.03 Identical polygons share one physics shape
+ * 1.04 Static polygons can be added to a shared compound body
  */
 
 #pragma once
@@ -21,6 +24,8 @@
 
 class b2Body;
 class b2World;
+class b2Shape;
+struct b2FixtureDef;
 
 namespace cse335
 {
@@ -60,6 +65,19 @@ private:
     /// Restitution (elasticity) in the range [0, 1]
     double mRestitution = 0.5;
 
+    /// Shape vertices in meters as installed in the physics system,
+    /// if supplied. Otherwise they are computed from the polygon.
+    std::vector<b2Vec2> mShapeVertices;
+
+    /// Physics shape, shared with every identical polygon.
+    /// Looked up on first install.
+    std::shared_ptr<const b2Shape> mShape;
+
+    /// Set when installed as a fixture of a shared static body
+    bool mCompound = false;
+
+    void InstallCompound(b2FixtureDef& fixtureDef);
+
 public:
     PhysicsPolygon();
 
@@ -92,16 +110,32 @@ public:
 
     wxPoint2DDouble GetPosition();
 
-    void InstallPhysics(std::shared_ptr<b2World> world);
+    void InstallPhysics(std::shared_ptr<b2World> world, b2Body* compound = nullptr);
+
+    /**
+     * Is this a static body, one that never moves?
+     * @return true if static
+     */
+    bool IsStatic() const { return mType == b2_staticBody; }
 
     void SetDynamic();
     void SetKinematic();
     void SetPhysics(double density=1.0, double friction=0.5, double restitution=0.5);
 
+    /**
+     * Supply the physics shape vertices, already in meters and
+     * adjusted for the Box2D skin, so they are not computed at install.
+     * @param vertices Shape vertices
+     */
+    void SetShapeVertices(const std::vector<b2Vec2>& vertices) { mShapeVertices = vertices; mShape = nullptr; }
+
+    static std::vector<b2Vec2> ComputeShapeVertices(const std::vector<wxPoint2DDouble>& points);
+
     /**
      * Get the physics body for this component.
      *
-     * Only set after InstallPhysics has been called.
+     * Only set after InstallPhysics has been called. For a polygon
+     * installed in a compound body, this is the compound body.
      * @return b2Body object
      */
     b2Body* GetBody() {return mBody;}
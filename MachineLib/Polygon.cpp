@@ -10,9 +10,166 @@
 #include <wx/hyperlink.h>
 
 #include "Polygon.h"
+#include "ImageCache.h"
+#include "TextureAtlas.h"
 
 using namespace cse335;
 
+namespace {
+
+/// Largest distance in device pixels a drawn circle's edge
+/// may be from the true circle
+const double CircleTolerance = 0.5;
+
+/**
+ * Reduce an angle to the range -pi to pi
+ * @param x Angle in radians
+ * @return Equivalent angle
+ */
+constexpr double ReduceAngle(double x)
+{
+    while(x > M_PI) { x -= 2 * M_PI; }
+    while(x < -M_PI) { x += 2 * M_PI; }
+    return x;
+}
+
+/**
+ * Sine usable at compile time
+ * @param x Angle in radians
+ * @return Sine of the angle
+ */
+constexpr double ConstSin(double x)
+{
+    x = ReduceAngle(x);
+    double term = x, sum = x;
+    for(int n = 1; n < 16; n++)
+    {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+/**
+ * Cosine usable at compile time
+ * @param x Angle in radians
+ * @return Cosine of the angle
+ */
+constexpr double ConstCos(double x)
+{
+    x = ReduceAngle(x);
+    double term = 1, sum = 1;
+    for(int n = 1; n < 16; n++)
+    {
+        term *= -x * x / ((2 * n - 1) * (2 * n));
+        sum += term;
+    }
+    return sum;
+}
+
+/**
+ * Points on a circle of radius 1, generated at compile time
+ */
+template<int Steps>
+struct UnitCircle
+{
+    /// X of each point
+    double x[Steps] = {};
+
+    /// Y of each point
+    double y[Steps] = {};
+
+    /// Constructor
+    constexpr UnitCircle()
+    {
+        for(int i = 0; i < Steps; i++)
+        {
+            double angle = double(i) / double(Steps) * M_PI * 2;
+            x[i] = ConstCos(angle);
+            y[i] = ConstSin(angle);
+        }
+    }
+};
+
+constexpr UnitCircle<8> UnitCircle8;     ///< 8 step unit circle
+constexpr UnitCircle<16> UnitCircle16;   ///< 16 step unit circle
+constexpr UnitCircle<32> UnitCircle32;   ///< 32 step unit circle
+constexpr UnitCircle<64> UnitCircle64;   ///< 64 step unit circle
+
+/**
+ * A unit circle table of any size
+ */
+struct UnitTable
+{
+    /// Number of points
+    int steps;
+
+    /// X of each point
+    const double* x;
+
+    /// Y of each point
+    const double* y;
+};
+
+/// The unit circle tables in order of size
+const UnitTable UnitCircles[] = {
+    {8, UnitCircle8.x, UnitCircle8.y},
+    {16, UnitCircle16.x, UnitCircle16.y},
+    {32, UnitCircle32.x, UnitCircle32.y},
+    {64, UnitCircle64.x, UnitCircle64.y}};
+
+/**
+ * Find the unit circle table for a number of steps
+ * @param steps Number of steps
+ * @return Table, or nullptr if there is none that size
+ */
+const UnitTable* FindUnitCircle(int steps)
+{
+    for(auto& table : UnitCircles)
+    {
+        if(table.steps == steps)
+        {
+            return &table;
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * Get how many device pixels one unit covers, whatever the rotation
+ * @param graphics Graphics context with the current transform
+ * @return Scale factor
+ */
+double DeviceScale(std::shared_ptr<wxGraphicsContext> graphics)
+{
+    double a, b, c, d, tx, ty;
+    graphics->GetTransform().Get(&a, &b, &c, &d, &tx, &ty);
+    return sqrt(fabs(a * d - b * c));
+}
+
+/**
+ * Create the path for a circle
+ * @param graphics Graphics context to draw on
+ * @param radius Circle radius
+ * @param table Unit circle to scale
+ * @return Path
+ */
+wxGraphicsPath CirclePath(std::shared_ptr<wxGraphicsContext> graphics, double radius, const UnitTable& table)
+{
+    auto path = graphics->CreatePath();
+    path.MoveToPoint(radius * table.x[0], radius * table.y[0]);
+    for(int i=1; i<table.steps; i++)
+    {
+        path.AddLineToPoint(radius * table.x[i], radius * table.y[i]);
+    }
+    path.CloseSubpath();
+
+    return path;
+}
+
+}
+
 /**
  * Constructor
  */
@@ -64,25 +221,25 @@ void Polygon::Rectangle(double x, double y, double width, double height)
     if(width <= 0)
     {
         // Optional automatic width determination from image
-        if(!Assert(mImage != nullptr,
+        if(!Assert(!mImageFile.empty(),
                    L"You must select an image before calling Rectangle with no specified width."))
         {
             return;
         }
 
-        width = mImage->GetWidth();
+        width = mImageSize.GetWidth();
     }
 
     if(height <= 0)
     {
         // Optional automatic height determination from image
-        if(!Assert(mImage != nullptr,
+        if(!Assert(!mImageFile.empty(),
                L"You must select an image before calling Rectangle with no specified height."))
         {
             return;
         }
 
-        height = (int)(width * mImage->GetHeight() / mImage->GetWidth());
+        height = (int)(width * mImageSize.GetHeight() / mImageSize.GetWidth());
     }
 
     if(mInvertedY)
@@ -114,7 +271,7 @@ void Polygon::BottomCenteredRectangle(double width, double height)
 {
     if(width == 0)
     {
-        if(!Assert(mImage != nullptr,
+        if(!Assert(!mImageFile.empty(),
                 L"You must select an image before calling BottomCenteredRectangle with no width."))
         {
             return;
@@ -124,7 +281,7 @@ void Polygon::BottomCenteredRectangle(double width, double height)
     }
     else if(height == 0)
     {
-        if(!Assert(mImage != nullptr,
+        if(!Assert(!mImageFile.empty(),
                 L"You must select an image before calling BottomCenteredRectangle with no height."))
         {
             return;
@@ -145,13 +302,13 @@ void Polygon::CenteredSquare(double size)
 {
     if(size == 0)
     {
-        if(!Assert(mImage != nullptr,
+        if(!Assert(!mImageFile.empty(),
                 L"You must select an image before calling BottomCenteredRectangle."))
         {
             return;
         }
 
-        size = mImage->GetWidth();
+        size = mImageSize.GetWidth();
     }
 
     if(mInvertedY)
@@ -175,10 +332,19 @@ void Polygon::Circle(double radius, int steps)
 {
     mIsCircle = true;
 
+    // Common step counts come from tables made at compile time
+    auto table = FindUnitCircle(steps);
     for (int i = 0; i < steps; i++)
     {
-        double angle = double(i) / double(steps) * M_PI * 2;
-        AddPoint(radius * cos(angle), radius * sin(angle));
+        if (table != nullptr)
+        {
+            AddPoint(radius * table->x[i], radius * table->y[i]);
+        }
+        else
+        {
+            double angle = double(i) / double(steps) * M_PI * 2;
+            AddPoint(radius * cos(angle), radius * sin(angle));
+        }
     }
 }
 
@@ -199,20 +365,27 @@ void Polygon::SetColor(wxColour color)
  */
 void Polygon::SetImage(std::wstring filename)
 {
-    // Prevent error popup from wxWidgets
-    wxLogNull logNo;
-
-    mImage = std::make_unique<wxImage>();
-    if(mImage->LoadFile(filename, wxBITMAP_TYPE_ANY))
+    mImage = ImageCache::Load(filename);
+    if(mImage != nullptr)
     {
+        mImageFile = filename;
+        mImageSize = mImage->GetSize();
         mMode = Mode::Image;
+        mBitmapDirty = true;
     }
     else
     {
         std::wstringstream str;
         str << L"Unable to load '" << filename << "'" << std::endl;
-        wxMessageBox(str.str(), L"Polygon Image File Load Failure!");
-        mImage = nullptr;
+        if(wxIsMainThread())
+        {
+            wxMessageBox(str.str(), L"Polygon Image File Load Failure!");
+        }
+        else
+        {
+            // Machines may be built on worker threads, which cannot show dialogs
+            wxLogError(str.str());
+        }
     }
 }
 
@@ -283,6 +456,12 @@ void Polygon::DrawPolygon(std::shared_ptr<wxGraphicsContext> graphics, double x,
  */
 void Polygon::DrawColorPolygon(std::shared_ptr<wxGraphicsContext> graphics, double x, double y, double rotation)
 {
+    if(mIsCircle && FindUnitCircle((int)mPoints.size()) != nullptr)
+    {
+        DrawColorCircle(graphics, x, y, rotation);
+        return;
+    }
+
     if(mPath.IsNull())
     {
         // Create the graphics path
@@ -308,47 +487,69 @@ void Polygon::DrawColorPolygon(std::shared_ptr<wxGraphicsContext> graphics, doub
 }
 
 /**
- * Draw the polygon as a texture mapped image.
- *
- * This is accomplished by drawing the bitmap image clipped
- * by the supplied polygon points.
+ * Draw a circle as a solid color-filled polygon
  *
+ * Circles drawn small use fewer steps, as long as the edge stays
+ * within CircleTolerance pixels of the circle, but never more
+ * than the circle was created with.
  * @param graphics Graphics object to draw on
  * @param x X location to draw in pixels
  * @param y Y location to draw in pixels
- * @param rotation Rotation in turn
+ * @param rotation Rotation in turns
  */
-void Polygon::DrawImagePolygon(std::shared_ptr<wxGraphicsContext> graphics, double x, double y, double rotation)
+void Polygon::DrawColorCircle(std::shared_ptr<wxGraphicsContext> graphics, double x, double y, double rotation)
 {
-    if(mBitmapDirty || mGraphicsBitmap.IsNull())
-    {
-#ifdef WIN32
-        // Implementation of opacity for Windows systems.
-        // Windows does not support transparency layers.
-        if(mOpacity < 1) {
-            // Ensure the image has an alpha map
-            if (!mImage->HasAlpha()) {
-                mImage->InitAlpha();
-            }
+    double radius = Radius() * DeviceScale(graphics);
 
-            wxImage img = mImage->Copy();
-
-            unsigned char *alpha = img.GetAlpha();
-            for(int i=0; i<img.GetWidth()*img.GetHeight(); i++)
-            {
-                alpha[i] = int(alpha[i] * mOpacity);
-            }
+    const UnitTable* table = nullptr;
+    for(auto& candidate : UnitCircles)
+    {
+        table = &candidate;
 
-            mGraphicsBitmap = graphics->CreateBitmapFromImage(img);
-        }
-        else
+        // 1 - cos of one step bounds how far the edge cuts inside
+        if(candidate.steps >= (int)mPoints.size() || radius * (1 - candidate.x[1]) <= CircleTolerance)
         {
-            mGraphicsBitmap = graphics->CreateBitmapFromImage(*mImage);
+            break;
         }
-#else
-        mGraphicsBitmap = graphics->CreateBitmapFromImage(*mImage);
-#endif
+    }
+
+    graphics->PushState();
+
+    graphics->Translate(x, y);
+    graphics->Rotate(rotation * M_PI * 2);
 
+    // Paths belong to the renderer that created them
+    if(mCirclePath.IsNull() || mCircleRenderer != graphics->GetRenderer() ||
+        mCircleSteps != table->steps || mCircleRadius != Radius())
+    {
+        mCircleRenderer = graphics->GetRenderer();
+        mCircleSteps = table->steps;
+        mCircleRadius = Radius();
+        mCirclePath = CirclePath(graphics, mCircleRadius, *table);
+    }
+
+    graphics->SetBrush(mBrush);
+    graphics->FillPath(mCirclePath);
+
+    graphics->PopState();
+}
+
+/**
+ * Draw the polygon as a texture mapped image.
+ *
+ * The image is stretched over the bounding box of the polygon.
+ * Anything outside the polygon is transparent in the bitmap, so
+ * no clipping is needed.
+ *
+ * @param graphics Graphics object to draw on
+ * @param x X location to draw in pixels
+ * @param y Y location to draw in pixels
+ * @param rotation Rotation in turn
+ */
+void Polygon::DrawImagePolygon(std::shared_ptr<wxGraphicsContext> graphics, double x, double y, double rotation)
+{
+    if(mBitmapDirty)
+    {
         //
         // Determine the top left and the size of the
         // region covered by our polygon
@@ -376,16 +577,73 @@ void Polygon::DrawImagePolygon(std::shared_ptr<wxGraphicsContext> graphics, doub
         }
 
         mImageClipRegionSize = imageClipRegionBottomRight - mImageClipRegionTopLeft;
+        ComputeMask();
+    }
 
-        mImageClipRegion.Clear();
-        std::vector<wxPoint> points;
-        for(auto point : mPoints)
+    // Bitmaps belong to the renderer that created them
+    auto level = SelectLevel(graphics);
+    if(mBitmapDirty || mGraphicsBitmap.IsNull() || mRenderer != graphics->GetRenderer() || mLevel != level)
+    {
+        mRenderer = graphics->GetRenderer();
+        mLevel = level;
+
+#ifdef WIN32
+        // Implementation of opacity for Windows systems.
+        // Windows does not support transparency layers.
+        auto source = mOpacity < 1 ? GetImage() : nullptr;
+        if(source != nullptr) {
+            // The image is shared, so only the copy is modified
+            wxImage img = source->Copy();
+
+            // Ensure the image has an alpha map
+            if (!img.HasAlpha()) {
+                img.InitAlpha();
+            }
+
+            if (!mMask.empty()) {
+                TextureAtlas::ApplyMask(img, mMask);
+            }
+
+            unsigned char *alpha = img.GetAlpha();
+            for(int i=0; i<img.GetWidth()*img.GetHeight(); i++)
+            {
+                alpha[i] = int(alpha[i] * mOpacity);
+            }
+
+            mGraphicsBitmap = graphics->CreateBitmapFromImage(img);
+        }
+        else if (!mMask.empty())
         {
-            points.push_back(wxPoint(int(point.m_x - mImageClipRegionTopLeft.m_x + 0.5),
-                    int(point.m_y - mImageClipRegionTopLeft.m_y + 0.5)));
+            mGraphicsBitmap = TextureAtlas::GetMaskedBitmap(graphics, mImageFile, mLevel, mMask);
+        }
+        else
+        {
+            mGraphicsBitmap = TextureAtlas::GetBitmap(graphics, mImageFile, mLevel);
+        }
+#else
+        if (!mMask.empty())
+        {
+            mGraphicsBitmap = TextureAtlas::GetMaskedBitmap(graphics, mImageFile, mLevel, mMask);
+        }
+        else
+        {
+            mGraphicsBitmap = TextureAtlas::GetBitmap(graphics, mImageFile, mLevel);
+        }
+#endif
+
+        // Images that were never packed get a bitmap of their own
+        if(mGraphicsBitmap.IsNull())
+        {
+            auto image = mLevel > 0 ? ImageCache::LoadLevel(mImageFile, mLevel) : GetImage();
+            if(image == nullptr)
+            {
+                return;
+            }
+
+            mGraphicsBitmap = graphics->CreateBitmapFromImage(*image);
         }
 
-        mImageClipRegion = wxRegion(points.size(), &points[0]);
+        ReleaseImage();
         mBitmapDirty = false;
     }
 
@@ -395,7 +653,6 @@ void Polygon::DrawImagePolygon(std::shared_ptr<wxGraphicsContext> graphics, doub
     graphics->Rotate(rotation * M_PI * 2);
 
     graphics->Translate(mImageClipRegionTopLeft.m_x, mImageClipRegionTopLeft.m_y);
-    graphics->Clip(mImageClipRegion);
 
     if(mInvertedY)
     {
@@ -411,6 +668,104 @@ void Polygon::DrawImagePolygon(std::shared_ptr<wxGraphicsContext> graphics, doub
     graphics->PopState();
 }
 
+/**
+ * Compute the mask baked into the bitmap from the polygon points
+ *
+ * Points are mapped into image coordinates the same way the bitmap
+ * is stretched over the bounding box. Polygons that fill their
+ * bounding box, such as unrotated rectangles, need no mask and can
+ * draw the shared image directly.
+ */
+void Polygon::ComputeMask()
+{
+    mMask.clear();
+
+    auto left = mImageClipRegionTopLeft.m_x;
+    auto top = mImageClipRegionTopLeft.m_y;
+    auto right = left + mImageClipRegionSize.m_x;
+    auto bottom = top + mImageClipRegionSize.m_y;
+
+    bool filled = mPoints.size() == 4;
+    for(auto point : mPoints)
+    {
+        filled = filled && (point.m_x == left || point.m_x == right) &&
+                (point.m_y == top || point.m_y == bottom);
+    }
+
+    if(filled || mImageClipRegionSize.m_x <= 0 || mImageClipRegionSize.m_y <= 0)
+    {
+        return;
+    }
+
+    for(auto point : mPoints)
+    {
+        double u = (point.m_x - left) / mImageClipRegionSize.m_x;
+        double v = (point.m_y - top) / mImageClipRegionSize.m_y;
+
+        // An inverted polygon draws the bitmap upside down
+        mMask.push_back(wxPoint2DDouble(u, mInvertedY ? 1 - v : v));
+    }
+}
+
+/**
+ * Select the image level closest to the size the polygon is drawn at
+ *
+ * The smallest level still at least as large as the polygon on screen
+ * is used, so we never scale a bitmap up.
+ * @param graphics Graphics context with the current transform
+ * @return Level number, 0 for the full size image
+ */
+int Polygon::SelectLevel(std::shared_ptr<wxGraphicsContext> graphics)
+{
+    double scale = DeviceScale(graphics);
+
+    double width = mImageClipRegionSize.m_x * scale;
+    double height = mImageClipRegionSize.m_y * scale;
+
+    int levels = ImageCache::GetLevelCount(mImageSize);
+#ifdef WIN32
+    // The opacity path makes its own full size bitmap
+    if(mOpacity < 1) {
+        levels = 1;
+    }
+#endif
+
+    int level = 0;
+    while(level + 1 < levels && (mImageSize.GetWidth() >> (level + 1)) >= width &&
+          (mImageSize.GetHeight() >> (level + 1)) >= height)
+    {
+        level++;
+    }
+
+    return level;
+}
+
+/**
+ * Get the decoded image, decoding it again if it was released
+ * @return Image, or nullptr if it can no longer be loaded
+ */
+std::shared_ptr<wxImage> Polygon::GetImage()
+{
+    if(mImage == nullptr && !mImageFile.empty())
+    {
+        mImage = ImageCache::Load(mImageFile);
+    }
+
+    return mImage;
+}
+
+/**
+ * Drop our reference to the decoded image once the bitmap exists,
+ * unless the image cache policy is to keep images.
+ */
+void Polygon::ReleaseImage()
+{
+    if(ImageCache::GetPolicy() == ImageCache::Policy::Release)
+    {
+        mImage = nullptr;
+    }
+}
+
 /**
  * Convenience function to draw a crosshair.
  * @param graphics Graphics object to draw on
@@ -435,12 +790,12 @@ void Polygon::DrawCrosshair(std::shared_ptr<wxGraphicsContext> graphics, double
 */
 int Polygon::GetImageWidth()
 {
-    if(!Assert(mImage != nullptr, L"You must specify an image before you can call GetImageWidth()"))
+    if(!Assert(!mImageFile.empty(), L"You must specify an image before you can call GetImageWidth()"))
     {
         return 0;
     }
 
-    return mImage->GetWidth();
+    return mImageSize.GetWidth();
 }
 
 
@@ -451,12 +806,12 @@ int Polygon::GetImageWidth()
 */
 int Polygon::GetImageHeight()
 {
-    if(!Assert(mImage != nullptr, L"You must specify an image before you can call GetImageHeight()"))
+    if(!Assert(!mImageFile.empty(), L"You must specify an image before you can call GetImageHeight()"))
     {
         return 0;
     }
 
-    return mImage->GetHeight();
+    return mImageSize.GetHeight();
 }
 
 
@@ -523,6 +878,12 @@ double Polygon::AverageLuminance(int x, int y, int wid, int hit)
 {
     assert(mMode == Mode::Image);
 
+    auto image = GetImage();
+    if(image == nullptr)
+    {
+        return 0;
+    }
+
     double sum = 0;
     int cnt = 0;
 
@@ -540,9 +901,9 @@ double Polygon::AverageLuminance(int x, int y, int wid, int hit)
                 continue;
             }
 
-            double red = mImage->GetRed(i, j);
-            double grn = mImage->GetGreen(i, j);
-            double blu = mImage->GetBlue(i, j);
+            double red = image->GetRed(i, j);
+            double grn = image->GetGreen(i, j);
+            double blu = image->GetBlue(i, j);
             sum += red + grn + blu;
             cnt += 3;
         }
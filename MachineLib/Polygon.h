@@ -2,7 +2,7 @@
  * @file Polygon.h
  *
  * @author Charles Owen
- * @version 1.05
+ * @version 1.11
  *
  * Generic polygon class that is used to make shapes we
  * will use in our project.
@@ -14,6 +14,12 @@
  * 1.03 Put into cse335 namespace, opacity support
  * 1.04 Added Circle function
  * 1.05 Special version that works with inverted Y axis
+ * 1.06 Decoded images are shared through ImageCache
+ * 1.07 Images are drawn from TextureAtlas pages when packed
+ * 1.08 Decoded image is released once the bitmap is created
+ * 1.09 Draws the image level closest to the on-screen size
+ * 1.10 Polygon mask is baked into the bitmap alpha instead of clipping
+ * 1.11 Circles use precomputed tables, shared paths and fewer steps when small
  */
 
 #pragma once
@@ -35,6 +41,7 @@ namespace cse335 {
 
         void DrawColorPolygon(std::shared_ptr<wxGraphicsContext> graphics, double x, double y, double r);
         void DrawImagePolygon(std::shared_ptr<wxGraphicsContext> graphics, double x, double y, double r);
+        void DrawColorCircle(std::shared_ptr<wxGraphicsContext> graphics, double x, double y, double r);
 
         /// Graphics path to use to draw
         wxGraphicsPath mPath;
@@ -56,14 +63,43 @@ namespace cse335 {
         /// The current mode
         Mode mMode = Mode::Unset;
 
-        /// The basic texture image we load
-        std::unique_ptr<wxImage> mImage;
+        /// The basic texture image we load, shared with
+        /// every other polygon using the same file. This is
+        /// released after the bitmap is created and decoded
+        /// again if it is needed.
+        std::shared_ptr<wxImage> mImage;
 
-        /// The graphics bitmap we actually draw
+        /// File the image was loaded from
+        std::wstring mImageFile;
+
+        /// Size of the image in pixels
+        wxSize mImageSize;
+
+        /// Renderer that created mGraphicsBitmap
+        wxGraphicsRenderer* mRenderer = nullptr;
+
+        /// Image level mGraphicsBitmap was created from
+        int mLevel = 0;
+
+        /// Path drawn for a color circle
+        wxGraphicsPath mCirclePath;
+
+        /// Renderer that created mCirclePath
+        wxGraphicsRenderer* mCircleRenderer = nullptr;
+
+        /// Number of steps in mCirclePath
+        int mCircleSteps = 0;
+
+        /// Radius mCirclePath was created with
+        double mCircleRadius = 0;
+
+        /// The graphics bitmap we actually draw. This is a
+        /// sub-bitmap of a TextureAtlas page if the image is packed.
         wxGraphicsBitmap mGraphicsBitmap;
 
-        /// The image clip region
-        wxRegion mImageClipRegion;
+        /// The polygon in image coordinates scaled to 0-1, baked into
+        /// the bitmap's alpha. Empty if the polygon fills its bounding box.
+        std::vector<wxPoint2DDouble> mMask;
 
         /// What is the top left point for the clip region?
         wxPoint2DDouble mImageClipRegionTopLeft;
@@ -90,6 +126,14 @@ namespace cse335 {
 
         bool Assert(bool condition, wxString msg, const wxString& url = wxEmptyString);
 
+        std::shared_ptr<wxImage> GetImage();
+
+        int SelectLevel(std::shared_ptr<wxGraphicsContext> graphics);
+
+        void ReleaseImage();
+
+        void ComputeMask();
+
         //<editor-fold desc="Code to support the deferred assertion message box" defaultstate="collapsed">
         /**
          * Class to display an error message dialog box after a delay
@@ -0,0 +1,235 @@
+/**
+ * @file Profiler.cpp
+ * @author djmik
+ */
+
+#include "pch.h"
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#include <typeinfo>
+#include <b2_time_step.h>
+#include "Profiler.h"
+#include "Component.h"
+#include "Trace.h"
+
+/**
+ * Add a sample
+ * @param milliseconds Time in milliseconds
+ */
+void Profiler::Statistic::Add(double milliseconds)
+{
+    if (mSamples.size() < Window)
+    {
+        mSamples.push_back(milliseconds);
+    }
+    else
+    {
+        mSamples[mNext] = milliseconds;
+    }
+
+    mNext = (mNext + 1) % Window;
+    mCount++;
+    mLast = milliseconds;
+}
+
+/**
+ * Get the average of the recent samples
+ * @return Time in milliseconds, 0 if there are none
+ */
+double Profiler::Statistic::GetAverage() const
+{
+    if (mSamples.empty())
+    {
+        return 0;
+    }
+
+    double sum = 0;
+    for (auto sample : mSamples)
+    {
+        sum += sample;
+    }
+
+    return sum / mSamples.size();
+}
+
+/**
+ * Get the largest of the recent samples
+ * @return Time in milliseconds, 0 if there are none
+ */
+double Profiler::Statistic::GetMax() const
+{
+    return mSamples.empty() ? 0 : *std::max_element(mSamples.begin(), mSamples.end());
+}
+
+/**
+ * Get the readable type name of a component
+ * @param component Component
+ * @return Class name
+ */
+std::string Profiler::TypeName(const Component *component)
+{
+    return Trace::ReadableName(typeid(*component).name());
+}
+
+/**
+ * Add a sample for a component instance and its time to the total
+ * for its type in the current frame
+ * @param frame Time by type so far this frame
+ * @param instances Statistics by instance
+ * @param index Component index within the machine
+ * @param component Component
+ * @param milliseconds Time taken
+ */
+void Profiler::AddInstance(std::map<std::string, double> &frame, std::vector<Statistic> &instances,
+                           size_t index, const Component *component, double milliseconds)
+{
+    if (index >= mInstanceTypes.size())
+    {
+        mInstanceTypes.resize(index + 1);
+    }
+
+    // Type names only need looking up the first time we see an instance
+    auto& type = mInstanceTypes[index];
+    if (type.empty())
+    {
+        type = TypeName(component);
+    }
+
+    if (index >= instances.size())
+    {
+        instances.resize(index + 1);
+    }
+
+    instances[index].Add(milliseconds);
+    frame[type] += milliseconds;
+}
+
+/**
+ * Add one sample per type holding its total time for the frame
+ * @param frame Time by type this frame, cleared for the next one
+ * @param types Statistics by type
+ */
+void Profiler::EndFrame(std::map<std::string, double> &frame, std::map<std::string, Statistic> &types)
+{
+    for (auto& [type, milliseconds] : frame)
+    {
+        types[type].Add(milliseconds);
+        milliseconds = 0;
+    }
+}
+
+/**
+ * Add the time a component took to update
+ * @param index Component index within the machine
+ * @param component Component
+ * @param milliseconds Time taken
+ */
+void Profiler::AddUpdate(size_t index, const Component *component, double milliseconds)
+{
+    AddInstance(mUpdateFrame, mUpdateInstances, index, component, milliseconds);
+}
+
+/**
+ * Add the time a component took to draw
+ * @param index Component index within the machine
+ * @param component Component
+ * @param milliseconds Time taken
+ */
+void Profiler::AddDraw(size_t index, const Component *component, double milliseconds)
+{
+    AddInstance(mDrawFrame, mDrawInstances, index, component, milliseconds);
+}
+
+/**
+ * Add the time for a whole machine update
+ *
+ * This ends the frame, so the component times added since the last
+ * update become one sample for each type.
+ * @param milliseconds Time taken
+ */
+void Profiler::AddMachineUpdate(double milliseconds)
+{
+    mUpdate.Add(milliseconds);
+    EndFrame(mUpdateFrame, mUpdateTypes);
+}
+
+/**
+ * Add the time for a whole machine draw
+ *
+ * This ends the frame, so the component times added since the last
+ * draw become one sample for each type.
+ * @param milliseconds Time taken
+ */
+void Profiler::AddMachineDraw(double milliseconds)
+{
+    mDraw.Add(milliseconds);
+    EndFrame(mDrawFrame, mDrawTypes);
+}
+
+/**
+ * Add the times Box2D measured for the last physics step
+ * @param profile Profile from b2World::GetProfile
+ */
+void Profiler::AddStep(const b2Profile &profile)
+{
+    mStep["step"].Add(profile.step);
+    mStep["collide"].Add(profile.collide);
+    mStep["solve"].Add(profile.solve);
+    mStep["solveInit"].Add(profile.solveInit);
+    mStep["solveVelocity"].Add(profile.solveVelocity);
+    mStep["solvePosition"].Add(profile.solvePosition);
+    mStep["broadphase"].Add(profile.broadphase);
+    mStep["solveTOI"].Add(profile.solveTOI);
+}
+
+/**
+ * Discard every statistic, such as when a different machine is shown
+ */
+void Profiler::Clear()
+{
+    mUpdateTypes.clear();
+    mDrawTypes.clear();
+    mUpdateFrame.clear();
+    mDrawFrame.clear();
+    mUpdateInstances.clear();
+    mDrawInstances.clear();
+    mInstanceTypes.clear();
+    mStep.clear();
+    mUpdate = Statistic();
+    mDraw = Statistic();
+}
+
+/**
+ * Describe the statistics as text
+ * @return One line per measurement with average and maximum in milliseconds
+ */
+std::wstring Profiler::Report() const
+{
+    std::wstringstream str;
+    str << std::fixed << std::setprecision(3);
+
+    auto line = [&str](const std::string& name, const Statistic& statistic) {
+        str << std::wstring(name.begin(), name.end()) << L": avg " << statistic.GetAverage()
+            << L" ms, max " << statistic.GetMax() << L" ms" << std::endl;
+    };
+
+    line("update", mUpdate);
+    for (const auto& [name, statistic] : mStep)
+    {
+        line("  physics " + name, statistic);
+    }
+
+    for (const auto& [name, statistic] : mUpdateTypes)
+    {
+        line("  update " + name, statistic);
+    }
+
+    line("draw", mDraw);
+    for (const auto& [name, statistic] : mDrawTypes)
+    {
+        line("  draw " + name, statistic);
+    }
+
+    return str.str();
+}
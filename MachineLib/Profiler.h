@@ -0,0 +1,202 @@
+/**
+ * @file Profiler.h
+ * @author djmik
+ *
+ * Timing of machine updates and draws
+ */
+
+#ifndef CANADIANEXPERIENCE_MACHINELIB_PROFILER_H
+#define CANADIANEXPERIENCE_MACHINELIB_PROFILER_H
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+class Component;
+struct b2Profile;
+
+/**
+ * Profiler class
+ *
+ * Collects how long each component takes to update and draw, by
+ * component type and by instance, and how long the physics step
+ * takes split into the phases Box2D reports in b2Profile.
+ *
+ * A machine only records times while a profiler is attached, so
+ * without one the cost is a single test per update and draw. Draw
+ * times are the time to issue the drawing calls; renderers that defer
+ * drawing do the rest later.
+ */
+class Profiler
+{
+public:
+    /// Clock used for timing
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * Rolling statistics for one measurement
+     *
+     * Averages and maximums cover the most recent samples.
+     */
+    class Statistic
+    {
+    private:
+        /// Most recent samples in milliseconds
+        std::vector<double> mSamples;
+
+        /// Where the next sample goes in mSamples
+        size_t mNext = 0;
+
+        /// Total number of samples ever added
+        size_t mCount = 0;
+
+        /// Most recent sample
+        double mLast = 0;
+
+    public:
+        void Add(double milliseconds);
+
+        double GetAverage() const;
+
+        double GetMax() const;
+
+        /**
+         * Get the most recent sample
+         * @return Time in milliseconds
+         */
+        double GetLast() const { return mLast; }
+
+        /**
+         * Get the number of samples ever added
+         * @return Sample count
+         */
+        size_t GetCount() const { return mCount; }
+    };
+
+private:
+    /// Update times by component type, one sample per machine update
+    /// holding the time of every component of that type
+    std::map<std::string, Statistic> mUpdateTypes;
+
+    /// Draw times by component type, one sample per machine draw
+    std::map<std::string, Statistic> mDrawTypes;
+
+    /// Update time by component type so far in the current update
+    std::map<std::string, double> mUpdateFrame;
+
+    /// Draw time by component type so far in the current draw
+    std::map<std::string, double> mDrawFrame;
+
+    /// Update times by component index within the machine
+    std::vector<Statistic> mUpdateInstances;
+
+    /// Draw times by component index within the machine
+    std::vector<Statistic> mDrawInstances;
+
+    /// Type name of each component index
+    std::vector<std::string> mInstanceTypes;
+
+    /// Physics step times by phase
+    std::map<std::string, Statistic> mStep;
+
+    /// Time for all of Machine::Update
+    Statistic mUpdate;
+
+    /// Time for all of Machine::Draw
+    Statistic mDraw;
+
+    static std::string TypeName(const Component* component);
+
+    void AddInstance(std::map<std::string, double>& frame, std::vector<Statistic>& instances,
+                     size_t index, const Component* component, double milliseconds);
+
+    static void EndFrame(std::map<std::string, double>& frame, std::map<std::string, Statistic>& types);
+
+public:
+    /// Number of recent samples statistics cover
+    static const size_t Window = 120;
+
+    /**
+     * Get the current time
+     * @return Clock time
+     */
+    static Clock::time_point Now() { return Clock::now(); }
+
+    /**
+     * Get the time since a starting point
+     * @param start Starting time
+     * @return Elapsed time in milliseconds
+     */
+    static double Since(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    void AddUpdate(size_t index, const Component* component, double milliseconds);
+
+    void AddDraw(size_t index, const Component* component, double milliseconds);
+
+    void AddStep(const b2Profile& profile);
+
+    void AddMachineUpdate(double milliseconds);
+
+    void AddMachineDraw(double milliseconds);
+
+    void Clear();
+
+    /**
+     * Get update times by component type
+     * @return Statistics by type name
+     */
+    const std::map<std::string, Statistic>& GetUpdateTypes() const { return mUpdateTypes; }
+
+    /**
+     * Get draw times by component type
+     * @return Statistics by type name
+     */
+    const std::map<std::string, Statistic>& GetDrawTypes() const { return mDrawTypes; }
+
+    /**
+     * Get update times by component instance
+     * @return Statistics by component index within the machine
+     */
+    const std::vector<Statistic>& GetUpdateInstances() const { return mUpdateInstances; }
+
+    /**
+     * Get draw times by component instance
+     * @return Statistics by component index within the machine
+     */
+    const std::vector<Statistic>& GetDrawInstances() const { return mDrawInstances; }
+
+    /**
+     * Get the type of each component instance
+     * @return Type names by component index within the machine
+     */
+    const std::vector<std::string>& GetInstanceTypes() const { return mInstanceTypes; }
+
+    /**
+     * Get physics step times by phase
+     *
+     * Phases are the members of b2Profile: step, collide, solve,
+     * solveInit, solveVelocity, solvePosition, broadphase and solveTOI.
+     * @return Statistics by phase name
+     */
+    const std::map<std::string, Statistic>& GetStep() const { return mStep; }
+
+    /**
+     * Get times for whole machine updates
+     * @return Statistic
+     */
+    const Statistic& GetUpdate() const { return mUpdate; }
+
+    /**
+     * Get times for whole machine draws
+     * @return Statistic
+     */
+    const Statistic& GetDraw() const { return mDraw; }
+
+    std::wstring Report() const;
+};
+
+#endif //CANADIANEXPERIENCE_MACHINELIB_PROFILER_H
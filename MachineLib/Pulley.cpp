@@ -5,6 +5,7 @@
 
 #include "pch.h"
 #include "Pulley.h"
+#include "StateHash.h"
 #include "RotationSource.h"
 #include "RotationSink.h"
 
@@ -32,63 +33,79 @@ void Pulley::Draw(std::shared_ptr<wxGraphicsContext> graphics)
 {
     mPulley.DrawPolygon(graphics, GetPosition().m_x, GetPosition().m_y, mSource->GetRotation());
 
-    if (mOtherPulley)
+    auto other = mOtherPulley.lock();
+    if (other)
     {
-        bool flip = false;
-        double r1 = mRadius;
-        double r2 = mOtherPulley->GetRadius();
-        auto p1 = GetPosition();
-        auto p2 = mOtherPulley->GetPosition();
-        // tan(θ) = (y2-y1)/(x2-x1)
-        double theta = atan2((p2.m_y - p1.m_y), (p2.m_x - p1.m_x));
-        // sin(ϕ) = (r2-r1)/|p2-p1|
-        double phi = asin((r2 - r1) /
-            sqrt(pow((p2.m_x - p1.m_x),2) +
-                pow((p2.m_y - p1.m_y), 2)));
-        double beta;
-        if (signbit(GetRotation()) == signbit(mOtherPulley->GetRotation()))
+        auto p2 = other->GetPosition();
+        if (!mBelt.valid || mBelt.from != GetPosition() || mBelt.to != p2 ||
+            mBelt.radius != other->GetRadius())
         {
-            // Same side connection
-            if ((p1.m_y >= p2.m_y) && (theta >= 0) && !flip)
-            {
-                // β=θ+ϕ+π/2
-                beta = theta + phi + (M_PI / 2.0);
-            }
-            else
-            {
-                // β=θ-ϕ+3π/2
-                beta = theta - phi + (3.0 * M_PI / 2.0);
-            }
-            // p1 + ( r1cos(β), r1sin(β) )
-            p1.m_x += r1 * cos(beta);
-            p1.m_y += r1 * sin(beta);
-            // p2 + ( r2cos(β), r2sin(β) )
-            p2.m_x += r2 * cos(beta);
-            p2.m_y += r2 * sin(beta);
-        }
-        else
-        {
-            // Opposite side connection
-            if ((p1.m_y <= p2.m_y) && (theta >= 0) && !flip)
-            {
-                // β=θ-ϕ+π/2
-                beta = theta + phi + (M_PI / 2.0);
-            }
-            else
-            {
-                // β=θ+ϕ+3π/2
-                beta = theta + phi + (3.0 * M_PI / 2.0);
-            }
-            // p1 + ( r1cos(β), r1sin(β) )
-            p1.m_x += r1 * cos(beta);
-            p1.m_y += r1 * sin(beta);
-            // p2 - ( r2cos(β), r2sin(β) )
-            p2.m_x -= r2 * cos(beta);
-            p2.m_y -= r2 * sin(beta);
+            ComputeBelt(*other);
         }
+
+        // Only the direction of rotation decides which belt is drawn
+        auto& ends = signbit(GetRotation()) == signbit(other->GetRotation()) ? mBelt.same : mBelt.crossed;
         graphics->SetPen(*wxBLACK_PEN);
-        graphics->StrokeLine(p1.m_x, p1.m_y, p2.m_x, p2.m_y);
+        graphics->StrokeLine(ends[0].m_x, ends[0].m_y, ends[1].m_x, ends[1].m_y);
+    }
+}
+
+/**
+ * Compute the belt tangent endpoints to the other pulley for
+ * both the same side and crossed connections
+ * @param other Pulley the belt goes to
+ */
+void Pulley::ComputeBelt(Pulley& other)
+{
+    double r1 = mRadius;
+    double r2 = other.GetRadius();
+    auto p1 = GetPosition();
+    auto p2 = other.GetPosition();
+
+    mBelt.from = p1;
+    mBelt.to = p2;
+    mBelt.radius = r2;
+    mBelt.valid = true;
+
+    // tan(θ) = (y2-y1)/(x2-x1)
+    double theta = atan2((p2.m_y - p1.m_y), (p2.m_x - p1.m_x));
+    // sin(ϕ) = (r2-r1)/|p2-p1|
+    double phi = asin((r2 - r1) /
+        sqrt(pow((p2.m_x - p1.m_x),2) +
+            pow((p2.m_y - p1.m_y), 2)));
+
+    // Same side connection
+    double beta;
+    if ((p1.m_y >= p2.m_y) && (theta >= 0))
+    {
+        // β=θ+ϕ+π/2
+        beta = theta + phi + (M_PI / 2.0);
+    }
+    else
+    {
+        // β=θ-ϕ+3π/2
+        beta = theta - phi + (3.0 * M_PI / 2.0);
     }
+    // p1 + ( r1cos(β), r1sin(β) )
+    mBelt.same[0] = wxPoint2DDouble(p1.m_x + r1 * cos(beta), p1.m_y + r1 * sin(beta));
+    // p2 + ( r2cos(β), r2sin(β) )
+    mBelt.same[1] = wxPoint2DDouble(p2.m_x + r2 * cos(beta), p2.m_y + r2 * sin(beta));
+
+    // Opposite side connection
+    if ((p1.m_y <= p2.m_y) && (theta >= 0))
+    {
+        // β=θ-ϕ+π/2
+        beta = theta + phi + (M_PI / 2.0);
+    }
+    else
+    {
+        // β=θ+ϕ+3π/2
+        beta = theta + phi + (3.0 * M_PI / 2.0);
+    }
+    // p1 + ( r1cos(β), r1sin(β) )
+    mBelt.crossed[0] = wxPoint2DDouble(p1.m_x + r1 * cos(beta), p1.m_y + r1 * sin(beta));
+    // p2 - ( r2cos(β), r2sin(β) )
+    mBelt.crossed[1] = wxPoint2DDouble(p2.m_x - r2 * cos(beta), p2.m_y - r2 * sin(beta));
 }
 
 /**
@@ -110,3 +127,21 @@ void Pulley::Update(double elapsed)
     double rotation = mSink->GetRotation();
     mSource->SetRotation(rotation);
 }
+
+/**
+ * Reset the pulley to its initial, unrotated state
+ */
+void Pulley::Reset()
+{
+    Component::Reset();
+    mSource->SetRotation(0);
+}
+
+/**
+ * Add the pulley rotation to a hash
+ * @param hash Hash to add to
+ */
+void Pulley::HashState(StateHash &hash)
+{
+    hash.Add(mSink->GetRotation());
+}
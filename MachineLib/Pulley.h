@@ -34,13 +34,51 @@ private:
     /// Radius of pulley wheel
     double mRadius;
 
-    /// Pulley currently connected to via belt
-    std::shared_ptr<Pulley> mOtherPulley;
+    /// Pulley currently connected to via belt. Belted pulleys refer
+    /// to each other, so this must not keep the other one alive.
+    std::weak_ptr<Pulley> mOtherPulley;
+
+    /**
+     * Belt tangent endpoints to the other pulley
+     *
+     * Pulleys do not move once placed, so these are computed once for
+     * both the same side and crossed belt. They are recomputed if
+     * either pulley has moved since.
+     */
+    struct Belt
+    {
+        /// Our position when computed
+        wxPoint2DDouble from;
+
+        /// Other pulley position when computed
+        wxPoint2DDouble to;
+
+        /// Other pulley radius when computed
+        double radius = 0;
+
+        /// Same side belt endpoints on this and the other pulley
+        wxPoint2DDouble same[2];
+
+        /// Crossed belt endpoints on this and the other pulley
+        wxPoint2DDouble crossed[2];
+
+        /// Set once computed
+        bool valid = false;
+    };
+
+    /// Cached belt geometry
+    Belt mBelt;
+
+    void ComputeBelt(Pulley& other);
+
 public:
     Pulley(double radius);
     void Draw(std::shared_ptr<wxGraphicsContext> graphics) override;
     void SetImage(const std::wstring& imageName);
     void Update(double elapsed) override;
+    void Reset() override;
+
+    void HashState(StateHash& hash) override;
 
     /**
      * Get attached rotation source
@@ -64,7 +102,7 @@ public:
      * Get the other pulley this pulley is currently attached to (next in line if in chain of pulleys)
      * @param other
      */
-    void SetOtherPulley(std::shared_ptr<Pulley>& other) { mOtherPulley = other; }
+    void SetOtherPulley(std::shared_ptr<Pulley>& other) { mOtherPulley = other; mBelt.valid = false; }
 };
 
 #endif //CANADIANEXPERIENCE_MACHINELIB_PULLEY_H
@@ -0,0 +1,165 @@
+/**
+ * @file ShapeCache.cpp
+ * @author djmik
+ */
+
+#include "pch.h"
+#include <b2_polygon_shape.h>
+#include <b2_circle_shape.h>
+#include "ShapeCache.h"
+#include "PhysicsPolygon.h"
+#include "Consts.h"
+
+/// Polygon shapes by polygon points in centimeters
+std::map<std::vector<double>, std::shared_ptr<const b2Shape>> ShapeCache::mPolygons;
+
+/// Polygon shapes by precomputed vertices in meters
+std::map<std::vector<float>, std::shared_ptr<const b2Shape>> ShapeCache::mVertices;
+
+/// Circle shapes by radius in centimeters
+std::map<double, std::shared_ptr<const b2Shape>> ShapeCache::mCircles;
+
+/// Are shapes shared? Otherwise each request builds a new shape.
+bool ShapeCache::mEnabled = true;
+
+/// Protects mPolygons, mVertices, mCircles and mEnabled
+std::mutex ShapeCache::mMutex;
+
+/**
+ * Create a polygon shape from vertices
+ * @param vertices Vertices in meters, adjusted for the Box2D skin
+ * @return Shape
+ */
+static std::shared_ptr<const b2Shape> MakePolygon(const std::vector<b2Vec2>& vertices)
+{
+    auto shape = std::make_shared<b2PolygonShape>();
+    shape->Set(vertices.data(), (int32)vertices.size());
+    return shape;
+}
+
+/**
+ * Create a circle shape
+ * @param radius Radius in centimeters
+ * @return Shape with the Box2D skin allowed for
+ */
+static std::shared_ptr<const b2Shape> MakeCircle(double radius)
+{
+    auto circle = std::make_shared<b2CircleShape>();
+    circle->m_radius = radius / Consts::MtoCM - 0.005;
+    return circle;
+}
+
+/**
+ * Get the shape for a polygon
+ * @param points Polygon points in centimeters
+ * @return Shared shape with the Box2D skin allowed for
+ */
+std::shared_ptr<const b2Shape> ShapeCache::Polygon(const std::vector<wxPoint2DDouble> &points)
+{
+    std::vector<double> key;
+    key.reserve(points.size() * 2);
+    for (auto point : points)
+    {
+        key.push_back(point.m_x);
+        key.push_back(point.m_y);
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mEnabled)
+    {
+        return MakePolygon(cse335::PhysicsPolygon::ComputeShapeVertices(points));
+    }
+
+    auto& shape = mPolygons[key];
+    if (shape == nullptr)
+    {
+        shape = MakePolygon(cse335::PhysicsPolygon::ComputeShapeVertices(points));
+    }
+
+    return shape;
+}
+
+/**
+ * Get the shape for precomputed vertices
+ * @param vertices Vertices in meters, adjusted for the Box2D skin
+ * @return Shared shape
+ */
+std::shared_ptr<const b2Shape> ShapeCache::Polygon(const std::vector<b2Vec2> &vertices)
+{
+    std::vector<float> key;
+    key.reserve(vertices.size() * 2);
+    for (auto vertex : vertices)
+    {
+        key.push_back(vertex.x);
+        key.push_back(vertex.y);
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mEnabled)
+    {
+        return MakePolygon(vertices);
+    }
+
+    auto& shape = mVertices[key];
+    if (shape == nullptr)
+    {
+        shape = MakePolygon(vertices);
+    }
+
+    return shape;
+}
+
+/**
+ * Get the shape for a circle
+ * @param radius Radius in centimeters
+ * @return Shared shape with the Box2D skin allowed for
+ */
+std::shared_ptr<const b2Shape> ShapeCache::Circle(double radius)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mEnabled)
+    {
+        return MakeCircle(radius);
+    }
+
+    auto& shape = mCircles[radius];
+    if (shape == nullptr)
+    {
+        shape = MakeCircle(radius);
+    }
+
+    return shape;
+}
+
+/**
+ * Get the number of distinct shapes
+ * @return Shape count
+ */
+size_t ShapeCache::GetCount()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mPolygons.size() + mVertices.size() + mCircles.size();
+}
+
+/**
+ * Discard every shape. Bodies keep the shapes they already have.
+ */
+void ShapeCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mPolygons.clear();
+    mVertices.clear();
+    mCircles.clear();
+}
+
+/**
+ * Turn sharing of shapes on or off
+ *
+ * Shapes already handed out are not affected.
+ * @param enabled true to share shapes between identical bodies
+ */
+void ShapeCache::SetEnabled(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEnabled = enabled;
+}
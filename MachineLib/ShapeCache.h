@@ -0,0 +1,63 @@
+/**
+ * @file ShapeCache.h
+ * @author djmik
+ *
+ * Cache of physics shapes shared by identical bodies
+ */
+
+#ifndef CANADIANEXPERIENCE_MACHINELIB_SHAPECACHE_H
+#define CANADIANEXPERIENCE_MACHINELIB_SHAPECACHE_H
+
+#include <map>
+#include <mutex>
+#include <vector>
+#include <b2_math.h>
+
+class b2Shape;
+
+/**
+ * Shape cache class
+ *
+ * Each distinct polygon or circle has its Box2D shape built once:
+ * the skin adjusted vertices, convex hull, normals and centroid are
+ * computed the first time and every identical body after that, and
+ * every reinstall after a reset, shares the result. Installing a body
+ * is then only body creation and fixture attachment.
+ *
+ * Shapes are immutable once created and may be shared across threads
+ * building machines. Sharing can be turned off, which gives every body
+ * a shape of its own built the same way.
+ */
+class ShapeCache
+{
+private:
+    /// Polygon shapes by polygon points in centimeters
+    static std::map<std::vector<double>, std::shared_ptr<const b2Shape>> mPolygons;
+
+    /// Polygon shapes by precomputed vertices in meters
+    static std::map<std::vector<float>, std::shared_ptr<const b2Shape>> mVertices;
+
+    /// Circle shapes by radius in centimeters
+    static std::map<double, std::shared_ptr<const b2Shape>> mCircles;
+
+    /// Are shapes shared? Otherwise each request builds a new shape.
+    static bool mEnabled;
+
+    /// Protects mPolygons, mVertices, mCircles and mEnabled
+    static std::mutex mMutex;
+
+public:
+    static std::shared_ptr<const b2Shape> Polygon(const std::vector<wxPoint2DDouble>& points);
+
+    static std::shared_ptr<const b2Shape> Polygon(const std::vector<b2Vec2>& vertices);
+
+    static std::shared_ptr<const b2Shape> Circle(double radius);
+
+    static size_t GetCount();
+
+    static void Clear();
+
+    static void SetEnabled(bool enabled);
+};
+
+#endif //CANADIANEXPERIENCE_MACHINELIB_SHAPECACHE_H
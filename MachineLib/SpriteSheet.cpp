@@ -0,0 +1,211 @@
+/**
+ * @file SpriteSheet.cpp
+ * @author djmik
+ */
+
+#include "pch.h"
+#include <cmath>
+#include <cstring>
+#include "SpriteSheet.h"
+#include "ImageCache.h"
+
+/// Shared sheets by the files they are made from
+std::map<std::vector<std::wstring>, std::shared_ptr<SpriteSheet>> SpriteSheet::mSheets;
+
+/// Protects mSheets
+std::mutex SpriteSheet::mMutex;
+
+/**
+ * Constructor
+ * @param files A single image holding the frames in a row, or one image per frame
+ * @param frames Number of frames in a single image. Ignored for one image per frame.
+ */
+SpriteSheet::SpriteSheet(const std::vector<std::wstring> &files, int frames) : mFiles(files)
+{
+    mFrameCount = files.size() == 1 ? frames : (int)files.size();
+    mImage = Build();
+    if (mImage == nullptr)
+    {
+        mFrameCount = 0;
+    }
+}
+
+/**
+ * Get a shared sheet stored as a single image
+ * @param filename Image file with the frames side by side
+ * @param frames Number of frames in the image
+ * @return Sprite sheet. Check IsOk to see if it loaded.
+ */
+std::shared_ptr<SpriteSheet> SpriteSheet::Get(const std::wstring &filename, int frames)
+{
+    std::vector<std::wstring> files{filename};
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto& sheet = mSheets[files];
+    if (sheet == nullptr)
+    {
+        sheet = std::make_shared<SpriteSheet>(files, frames);
+    }
+
+    return sheet;
+}
+
+/**
+ * Get a shared sheet built from one image per frame
+ *
+ * Frames are scaled to the size of the first one if they differ.
+ * @param frames Image files in frame order
+ * @return Sprite sheet. Check IsOk to see if it loaded.
+ */
+std::shared_ptr<SpriteSheet> SpriteSheet::Get(const std::vector<std::wstring> &frames)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto& sheet = mSheets[frames];
+    if (sheet == nullptr)
+    {
+        sheet = std::make_shared<SpriteSheet>(frames, (int)frames.size());
+    }
+
+    return sheet;
+}
+
+/**
+ * Forget every shared sheet
+ *
+ * Components already holding a sheet keep drawing it.
+ */
+void SpriteSheet::Clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mSheets.clear();
+}
+
+/**
+ * Select the frame for a point in an animation cycle
+ * @param phase Position in the cycle. Each whole number is one
+ * complete cycle and negative values run the cycle backwards.
+ * @param count Number of frames in the cycle
+ * @return Frame index from 0 to count - 1
+ */
+int SpriteSheet::FrameAt(double phase, int count)
+{
+    if (count <= 0)
+    {
+        return 0;
+    }
+
+    double fraction = fabs(fmod(phase, 1));
+    return std::min(int(fraction * count), count - 1);
+}
+
+/**
+ * Load the sheet image through ImageCache
+ * @return Sheet image with the frames in a row, or nullptr if
+ * any image cannot be loaded
+ */
+std::shared_ptr<wxImage> SpriteSheet::Build()
+{
+    if (mFiles.empty() || mFrameCount <= 0)
+    {
+        return nullptr;
+    }
+
+    if (mFiles.size() == 1)
+    {
+        auto image = ImageCache::Load(mFiles[0]);
+        if (image == nullptr || image->GetWidth() < mFrameCount)
+        {
+            return nullptr;
+        }
+
+        mFrameSize = wxSize(image->GetWidth() / mFrameCount, image->GetHeight());
+        return image;
+    }
+
+    std::shared_ptr<wxImage> sheet;
+    for (int frame = 0; frame < mFrameCount; frame++)
+    {
+        auto image = ImageCache::Load(mFiles[frame]);
+        if (image == nullptr)
+        {
+            return nullptr;
+        }
+
+        if (sheet == nullptr)
+        {
+            mFrameSize = image->GetSize();
+            sheet = std::make_shared<wxImage>(mFrameSize.GetWidth() * mFrameCount, mFrameSize.GetHeight(), false);
+            sheet->InitAlpha();
+        }
+
+        // The frame is shared, so only a copy is changed
+        wxImage copy = image->GetSize() == mFrameSize ? *image :
+            image->Scale(mFrameSize.GetWidth(), mFrameSize.GetHeight(), wxIMAGE_QUALITY_HIGH);
+        if (!copy.HasAlpha())
+        {
+            copy = copy.Copy();
+            copy.InitAlpha();
+        }
+
+        int width = mFrameSize.GetWidth();
+        int sheetWidth = sheet->GetWidth();
+        for (int row = 0; row < mFrameSize.GetHeight(); row++)
+        {
+            size_t source = (size_t)row * width;
+            size_t dest = (size_t)row * sheetWidth + frame * width;
+            std::memcpy(sheet->GetData() + dest * 3, copy.GetData() + source * 3, width * 3);
+            std::memcpy(sheet->GetAlpha() + dest, copy.GetAlpha() + source, width);
+        }
+    }
+
+    return sheet;
+}
+
+/**
+ * Draw one frame centered on a point
+ *
+ * The frame is drawn upside down to match the inverted Y axis
+ * polygons use.
+ * @param graphics Graphics context to draw on
+ * @param frame Frame index
+ * @param x X location of the center
+ * @param y Y location of the center
+ * @param width Width to draw
+ * @param height Height to draw
+ */
+void SpriteSheet::Draw(std::shared_ptr<wxGraphicsContext> graphics, int frame,
+                       double x, double y, double width, double height)
+{
+    if (frame < 0 || frame >= mFrameCount)
+    {
+        return;
+    }
+
+    // Bitmaps belong to the renderer that created them
+    if (mBitmap.IsNull() || mRenderer != graphics->GetRenderer())
+    {
+        auto image = mImage != nullptr ? mImage : Build();
+        if (image == nullptr)
+        {
+            return;
+        }
+
+        mBitmap = graphics->CreateBitmapFromImage(*image);
+        mRenderer = graphics->GetRenderer();
+
+        mFrameBitmaps.clear();
+        for (int i = 0; i < mFrameCount; i++)
+        {
+            mFrameBitmaps.push_back(graphics->CreateSubBitmap(mBitmap, i * mFrameSize.GetWidth(), 0,
+                                                              mFrameSize.GetWidth(), mFrameSize.GetHeight()));
+        }
+
+        mImage = ImageCache::GetPolicy() == ImageCache::Policy::Release ? nullptr : image;
+    }
+
+    graphics->PushState();
+    graphics->Translate(x - width / 2, y - height / 2);
+    graphics->Scale(1, -1);
+    graphics->DrawBitmap(mFrameBitmaps[frame], 0, -height, width, height);
+    graphics->PopState();
+}
@@ -0,0 +1,102 @@
+/**
+ * @file SpriteSheet.h
+ * @author djmik
+ *
+ * Animation frames drawn from one shared image
+ */
+
+#ifndef CANADIANEXPERIENCE_MACHINELIB_SPRITESHEET_H
+#define CANADIANEXPERIENCE_MACHINELIB_SPRITESHEET_H
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+/**
+ * Sprite sheet class
+ *
+ * A sprite sheet is a single image holding every frame of an animation
+ * side by side. The sheet is one graphics bitmap and each frame is a
+ * sub-bitmap of it, so every component drawing the animation shares
+ * one texture.
+ *
+ * Sheets are either an image file with the frames in a row, or built
+ * from one file per frame. They are shared like ImageCache images and
+ * obtained through Get, which may be called from worker threads
+ * building machines. Bitmaps are only created on the drawing thread.
+ *
+ * Under the ImageCache Release policy the sheet's pixels are freed
+ * once its bitmap exists and rebuilt if the renderer changes.
+ */
+class SpriteSheet
+{
+private:
+    /// Image files the sheet is made from
+    std::vector<std::wstring> mFiles;
+
+    /// Number of frames in the sheet
+    int mFrameCount = 0;
+
+    /// Size of one frame in pixels
+    wxSize mFrameSize;
+
+    /// Sheet pixels, null once released
+    std::shared_ptr<wxImage> mImage;
+
+    /// Bitmap of the whole sheet
+    wxGraphicsBitmap mBitmap;
+
+    /// Sub-bitmap of each frame
+    std::vector<wxGraphicsBitmap> mFrameBitmaps;
+
+    /// Renderer the bitmaps were created with
+    wxGraphicsRenderer* mRenderer = nullptr;
+
+    /// Shared sheets by the files they are made from
+    static std::map<std::vector<std::wstring>, std::shared_ptr<SpriteSheet>> mSheets;
+
+    /// Protects mSheets
+    static std::mutex mMutex;
+
+    std::shared_ptr<wxImage> Build();
+
+public:
+    SpriteSheet(const std::vector<std::wstring>& files, int frames);
+
+    /// Copy constructor (disabled)
+    SpriteSheet(const SpriteSheet &) = delete;
+
+    /// Assignment operator (disabled)
+    void operator=(const SpriteSheet &) = delete;
+
+    static std::shared_ptr<SpriteSheet> Get(const std::wstring& filename, int frames);
+
+    static std::shared_ptr<SpriteSheet> Get(const std::vector<std::wstring>& frames);
+
+    static void Clear();
+
+    static int FrameAt(double phase, int count);
+
+    void Draw(std::shared_ptr<wxGraphicsContext> graphics, int frame,
+              double x, double y, double width, double height);
+
+    /**
+     * Was the sheet loaded?
+     * @return true if the sheet has frames to draw
+     */
+    bool IsOk() const { return mFrameCount > 0; }
+
+    /**
+     * Get the number of frames in the sheet
+     * @return Frame count
+     */
+    int GetFrameCount() const { return mFrameCount; }
+
+    /**
+     * Get the size of one frame
+     * @return Frame size in pixels
+     */
+    wxSize GetFrameSize() const { return mFrameSize; }
+};
+
+#endif //CANADIANEXPERIENCE_MACHINELIB_SPRITESHEET_H
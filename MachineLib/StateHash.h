@@ -0,0 +1,72 @@
+/**
+ * @file StateHash.h
+ * @author djmik
+ *
+ * Hash of simulation state used to check runs are identical
+ */
+
+#ifndef CANADIANEXPERIENCE_MACHINELIB_STATEHASH_H
+#define CANADIANEXPERIENCE_MACHINELIB_STATEHASH_H
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * State hash class
+ *
+ * A 64 bit FNV-1a hash of the exact bits of the values added to it.
+ * Two runs only hash the same if every value added is bit for bit
+ * the same, so this detects even the last-bit differences that a
+ * change in evaluation order or compiler flags produces.
+ */
+class StateHash
+{
+private:
+    /// FNV-1a 64 bit offset basis
+    static const uint64_t Basis = 14695981039346656037ull;
+
+    /// FNV-1a 64 bit prime
+    static const uint64_t Prime = 1099511628211ull;
+
+    /// Hash of everything added so far
+    uint64_t mHash = Basis;
+
+public:
+    /**
+     * Add raw bytes to the hash
+     * @param data Bytes to add
+     * @param size Number of bytes
+     */
+    void Add(const void* data, size_t size)
+    {
+        auto bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            mHash = (mHash ^ bytes[i]) * Prime;
+        }
+    }
+
+    /**
+     * Add a plain value to the hash
+     * @param value Value to add
+     */
+    template<typename T> void Add(T value)
+    {
+        static_assert(std::is_arithmetic<T>::value, "Only plain numbers and flags can be hashed");
+        if constexpr (std::is_floating_point<T>::value)
+        {
+            // -0 and 0 behave identically, so hash them the same
+            value += T(0);
+        }
+        Add(&value, sizeof(T));
+    }
+
+    /**
+     * Get the hash of everything added so far
+     * @return Hash value
+     */
+    uint64_t Get() const { return mHash; }
+};
+
+#endif //CANADIANEXPERIENCE_MACHINELIB_STATEHASH_H
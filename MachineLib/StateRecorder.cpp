@@ -0,0 +1,288 @@
+/**
+ * @file StateRecorder.cpp
+ * @author djmik
+ */
+
+#include "pch.h"
+#include <wx/file.h>
+#include <algorithm>
+#include <b2_world.h>
+#include <b2_body.h>
+#include "StateRecorder.h"
+#include "StateHash.h"
+#include "BinaryStream.h"
+#include "Machine.h"
+#include "Component.h"
+
+/// Identifies a state recording file
+const char RecordingMagic[4] = {'I', 'M', 'S', 'R'};
+
+/// Version of the recording format. Files from other versions are rejected.
+const uint32_t RecordingVersion = 1;
+
+/**
+ * Hash the current state of a machine
+ * @param machine Machine to hash
+ * @return Frame holding the body, component and overall hashes
+ */
+StateRecorder::Frame StateRecorder::Capture(Machine &machine)
+{
+    Frame frame;
+
+    // Box2D lists the newest body first
+    for (auto body = machine.GetWorld()->GetBodyList(); body != nullptr; body = body->GetNext())
+    {
+        StateHash hash;
+        auto& position = body->GetPosition();
+        auto& velocity = body->GetLinearVelocity();
+        hash.Add(position.x);
+        hash.Add(position.y);
+        hash.Add(body->GetAngle());
+        hash.Add(velocity.x);
+        hash.Add(velocity.y);
+        hash.Add(body->GetAngularVelocity());
+        hash.Add(body->IsAwake());
+        frame.bodies.push_back(hash.Get());
+    }
+    std::reverse(frame.bodies.begin(), frame.bodies.end());
+
+    for (const auto& component : machine.GetComponents())
+    {
+        StateHash hash;
+        component->HashState(hash);
+        frame.components.push_back(hash.Get());
+    }
+
+    StateHash hash;
+    hash.Add(frame.bodies.size());
+    hash.Add(frame.bodies.data(), frame.bodies.size() * sizeof(uint64_t));
+    hash.Add(frame.components.size());
+    hash.Add(frame.components.data(), frame.components.size() * sizeof(uint64_t));
+    frame.hash = hash.Get();
+
+    return frame;
+}
+
+/**
+ * Run a machine from its initial state, recording every frame
+ *
+ * The machine is advanced the same way MachineSystem advances it
+ * when playing forward.
+ * @param machine Machine to run. It is reset first.
+ * @param frames Number of frames to run
+ * @param frameRate Frames per second
+ */
+void StateRecorder::Record(Machine &machine, int frames, double frameRate)
+{
+    mFrameRate = frameRate;
+    mFrames.clear();
+    mFrames.reserve(frames + 1);
+
+    machine.Reset();
+    mFrames.push_back(Capture(machine));
+
+    for (int frame = 0; frame < frames; frame++)
+    {
+        machine.SetCurrentTime(frame / frameRate);
+        machine.Update(1.0 / frameRate);
+        mFrames.push_back(Capture(machine));
+    }
+}
+
+/**
+ * Save the recording to a file
+ * @param filename File to write
+ * @return true if successful
+ */
+bool StateRecorder::Save(const std::wstring &filename)
+{
+    // Prevent error popup from wxWidgets
+    wxLogNull logNo;
+    mError.clear();
+
+    BinaryWriter writer;
+    for (auto c : RecordingMagic)
+    {
+        writer.Write(c);
+    }
+
+    writer.Write(RecordingVersion);
+    writer.Write(mFrameRate);
+    writer.Write<uint32_t>(mFrames.size());
+    for (const auto& frame : mFrames)
+    {
+        writer.Write(frame.hash);
+        writer.Write<uint32_t>(frame.bodies.size());
+        writer.WriteBytes(frame.bodies.data(), frame.bodies.size() * sizeof(uint64_t));
+        writer.Write<uint32_t>(frame.components.size());
+        writer.WriteBytes(frame.components.data(), frame.components.size() * sizeof(uint64_t));
+    }
+
+    auto& buffer = writer.GetBuffer();
+    wxFile file;
+    if (!file.Create(filename, true) || file.Write(buffer.data(), buffer.size()) != buffer.size())
+    {
+        mError = L"Unable to write state recording '" + filename + L"'";
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Load a recording saved by Save
+ * @param filename File to read
+ * @return true if successful
+ */
+bool StateRecorder::Load(const std::wstring &filename)
+{
+    // Prevent error popup from wxWidgets
+    wxLogNull logNo;
+    mError.clear();
+
+    wxFile file;
+    if (!file.Open(filename))
+    {
+        mError = L"Unable to open state recording '" + filename + L"'";
+        return false;
+    }
+
+    std::vector<char> buffer(file.Length());
+    if (file.Read(buffer.data(), buffer.size()) != (ssize_t)buffer.size())
+    {
+        mError = L"Unable to read state recording '" + filename + L"'";
+        return false;
+    }
+
+    BinaryReader reader(buffer);
+    for (auto c : RecordingMagic)
+    {
+        if (reader.Read<char>() != c)
+        {
+            mError = L"'" + filename + L"' is not a state recording";
+            return false;
+        }
+    }
+
+    if (reader.Read<uint32_t>() != RecordingVersion)
+    {
+        mError = L"'" + filename + L"' was recorded by a different version";
+        return false;
+    }
+
+    auto readHashes = [&reader](std::vector<uint64_t>& hashes) {
+        auto count = reader.Read<uint32_t>();
+        for (uint32_t i = 0; i < count && !reader.IsOverrun(); i++)
+        {
+            hashes.push_back(reader.Read<uint64_t>());
+        }
+    };
+
+    std::vector<Frame> frames;
+    auto frameRate = reader.Read<double>();
+    auto count = reader.Read<uint32_t>();
+    for (uint32_t i = 0; i < count && !reader.IsOverrun(); i++)
+    {
+        Frame frame;
+        frame.hash = reader.Read<uint64_t>();
+        readHashes(frame.bodies);
+        readHashes(frame.components);
+        frames.push_back(std::move(frame));
+    }
+
+    if (reader.IsOverrun())
+    {
+        mError = L"'" + filename + L"' is truncated";
+        return false;
+    }
+
+    mFrameRate = frameRate;
+    mFrames = std::move(frames);
+    return true;
+}
+
+/**
+ * Find the first index where two lists of hashes differ
+ * @param a First list
+ * @param b Second list
+ * @return Index, or -1 if the lists are identical
+ */
+static int FirstDifference(const std::vector<uint64_t>& a, const std::vector<uint64_t>& b)
+{
+    auto common = std::min(a.size(), b.size());
+    for (size_t i = 0; i < common; i++)
+    {
+        if (a[i] != b[i])
+        {
+            return (int)i;
+        }
+    }
+
+    // A body or component that only exists in one of them
+    return a.size() == b.size() ? -1 : (int)common;
+}
+
+/**
+ * Compare this recording with another
+ *
+ * A recording that stops early diverges at the first frame the
+ * other has and it does not.
+ * @param other Recording to compare to
+ * @return Where the recordings first differ
+ */
+StateRecorder::Divergence StateRecorder::Compare(const StateRecorder &other) const
+{
+    Divergence divergence;
+
+    auto common = std::min(mFrames.size(), other.mFrames.size());
+    for (size_t i = 0; i < common; i++)
+    {
+        auto& frame = mFrames[i];
+        auto& otherFrame = other.mFrames[i];
+        if (frame.hash != otherFrame.hash)
+        {
+            divergence.frame = (int)i;
+            divergence.body = FirstDifference(frame.bodies, otherFrame.bodies);
+            divergence.component = FirstDifference(frame.components, otherFrame.components);
+            return divergence;
+        }
+    }
+
+    if (mFrames.size() != other.mFrames.size())
+    {
+        divergence.frame = (int)common;
+    }
+
+    return divergence;
+}
+
+/**
+ * Describe where two recordings differ
+ * @param divergence Result of Compare
+ * @return Readable description
+ */
+std::wstring StateRecorder::Describe(const Divergence &divergence)
+{
+    if (!divergence.IsDivergent())
+    {
+        return L"No divergence";
+    }
+
+    auto description = L"Diverged at frame " + std::to_wstring(divergence.frame);
+    if (divergence.body >= 0)
+    {
+        description += L", body " + std::to_wstring(divergence.body);
+    }
+
+    if (divergence.component >= 0)
+    {
+        description += L", component " + std::to_wstring(divergence.component);
+    }
+
+    if (divergence.body < 0 && divergence.component < 0)
+    {
+        description += L", frame missing from one recording";
+    }
+
+    return description;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file StateRecorder.h
+ * @author djmik
+ *
+ * Records per-frame state hashes and finds where two runs diverge
+ */
+
+#ifndef CANADIANEXPERIENCE_MACHINELIB_STATERECORDER_H
+#define CANADIANEXPERIENCE_MACHINELIB_STATERECORDER_H
+
+class Machine;
+
+/**
+ * State recorder class
+ *
+ * Runs a machine frame by frame and keeps a hash of its state after
+ * each frame: one per physics body, covering the transform and
+ * velocities, and one per component, covering state that is not in
+ * the physics world. Recordings can be saved, loaded and compared,
+ * and a comparison reports the first frame, body and component that
+ * differ.
+ *
+ * Any change that should not alter the simulation, such as caching,
+ * restoring a snapshot or running on another thread, can be checked
+ * by comparing a recording made with it against one made without.
+ */
+class StateRecorder
+{
+public:
+    /**
+     * State of a machine at one frame
+     */
+    struct Frame
+    {
+        /// Hash of the whole frame
+        uint64_t hash = 0;
+
+        /// Hash of each physics body in creation order
+        std::vector<uint64_t> bodies;
+
+        /// Hash of each component in the order added to the machine
+        std::vector<uint64_t> components;
+    };
+
+    /**
+     * Where two recordings first differ
+     */
+    struct Divergence
+    {
+        /// First frame that differs, -1 if the recordings match
+        int frame = -1;
+
+        /// First body that differs within the frame, -1 if none does
+        int body = -1;
+
+        /// First component that differs within the frame, -1 if none does
+        int component = -1;
+
+        /**
+         * Do the recordings differ?
+         * @return true if a divergent frame was found
+         */
+        bool IsDivergent() const { return frame >= 0; }
+    };
+
+private:
+    /// Frame rate the recording was made at in frames per second
+    double mFrameRate = 30;
+
+    /// Recorded frames, starting with the state after Reset
+    std::vector<Frame> mFrames;
+
+    /// Message describing the last failure
+    std::wstring mError;
+
+public:
+    static Frame Capture(Machine& machine);
+
+    void Record(Machine& machine, int frames, double frameRate = 30);
+
+    bool Save(const std::wstring& filename);
+
+    bool Load(const std::wstring& filename);
+
+    Divergence Compare(const StateRecorder& other) const;
+
+    static std::wstring Describe(const Divergence& divergence);
+
+    /**
+     * Get the recorded frames
+     * @return Frames, starting with the state after Reset
+     */
+    const std::vector<Frame>& GetFrames() const { return mFrames; }
+
+    /**
+     * Get the frame rate the recording was made at
+     * @return Frames per second
+     */
+    double GetFrameRate() const { return mFrameRate; }
+
+    /**
+     * Get a description of the last failure
+     * @return Error message, empty if the last operation succeeded
+     */
+    const std::wstring& GetError() const { return mError; }
+};
+
+#endif //CANADIANEXPERIENCE_MACHINELIB_STATERECORDER_H
@@ -0,0 +1,224 @@
+/**
+ * @file StressFactory.cpp
+ * @author djmik
+ */
+
+#include "pch.h"
+#include <cmath>
+#include "ImageCache.h"
+#include "TextureAtlas.h"
+#include "Machine.h"
+#include "StressFactory.h"
+#include "DominoFactory.h"
+#include "DominoChain.h"
+#include "Body.h"
+#include "Pulley.h"
+#include "Hamster.h"
+#include "Conveyor.h"
+
+/// Directory within resources that contains the images.
+const std::wstring ImagesDirectory = L"/images";
+
+/// Images used directly by bodies in this machine
+const std::wstring BodyImages[] = {
+    L"/floor.png",
+    L"/ball1.png",
+    L"/pulley3.png"};
+
+/// Distance between dominoes at density 1 in centimeters
+const double DominoSpacing = 15;
+
+/// Closest dominoes can be packed in centimeters
+const double MinDominoSpacing = 6;
+
+/// How far the first domino of each row leans in turns
+const double DominoLean = 0.02;
+
+/// Distance between balls at density 1 in centimeters
+const double BallSpacing = 20;
+
+/// Closest balls can be packed in centimeters
+const double MinBallSpacing = 11;
+
+/// Radius of a ball in centimeters
+const int BallRadius = 5;
+
+/// Vertical distance between domino shelves in centimeters
+const int ShelfSpacing = 40;
+
+/// Thickness of the floor and shelves in centimeters
+const int ShelfThickness = 15;
+
+/// Horizontal distance between hamster chains in centimeters
+const int ChainSpacing = 160;
+
+/// Fraction of the bodies ForBodies makes balls
+const double BallFraction = 0.2;
+
+/// Bodies for each chain ForBodies adds
+const int BodiesPerChain = 1000;
+
+/// Most chains ForBodies adds
+const int MaxChains = 20;
+
+/**
+ * Create a stress machine
+ * @param resourcesDir Directory holding images for components created
+ * @param parameters What the machine contains
+ * @return machine pointer
+ */
+std::shared_ptr<Machine> StressFactory::Create(const std::wstring &resourcesDir, const Parameters &parameters)
+{
+    auto assets = Assets(resourcesDir);
+    ImageCache::Preload(assets);
+    TextureAtlas::Add(assets);
+
+    auto imagesDir = resourcesDir + ImagesDirectory;
+    auto machine = std::make_shared<Machine>();
+
+    auto dominoSpacing = std::max(MinDominoSpacing, DominoSpacing / parameters.density);
+    auto ballSpacing = std::max(MinBallSpacing, BallSpacing / parameters.density);
+
+    // Dominoes fill x from 0 to rowWidth, chains extend to the left
+    int rowWidth = (int)std::ceil(parameters.dominoesPerRow * dominoSpacing);
+    int chainsWidth = parameters.chains * ChainSpacing;
+    int left = -chainsWidth - ShelfThickness;
+    int right = std::max(rowWidth, 300) + ShelfThickness;
+
+    auto floor = std::make_shared<Body>();
+    floor->SetInitialPosition(0, 0);
+    floor->Rectangle(left, 0, right - left, ShelfThickness);
+    floor->SetImage(imagesDir + L"/floor.png");
+    machine->AddComponent(floor);
+
+    for (int row = 0; row < parameters.dominoRows; row++)
+    {
+        int y = ShelfThickness + row * ShelfSpacing;
+        if (row > 0)
+        {
+            auto shelf = std::make_shared<Body>();
+            shelf->SetInitialPosition(0, 0);
+            shelf->Rectangle(0, y - ShelfThickness, rowWidth, ShelfThickness);
+            shelf->SetImage(imagesDir + L"/floor.png");
+            machine->AddComponent(shelf);
+        }
+
+        // Each row is one chain, created and drawn in a single batch
+        auto chain = std::make_shared<DominoChain>(resourcesDir, row % 4);
+        chain->SetPosition(0, y);
+        chain->SetSpacing(dominoSpacing);
+        chain->SetLean(DominoLean);
+        chain->AddPoint(DominoFactory::DominoWidth / 2, 0);
+        chain->AddPoint(DominoFactory::DominoWidth / 2 + (parameters.dominoesPerRow - 1) * dominoSpacing, 0);
+        machine->AddComponent(chain);
+    }
+
+    // Balls in a grid over the dominoes, falling onto the start of each row
+    int columns = std::max(1, (int)(rowWidth / ballSpacing));
+    int top = ShelfThickness + parameters.dominoRows * ShelfSpacing + ShelfSpacing;
+    for (int i = 0; i < parameters.balls; i++)
+    {
+        auto ball = std::make_shared<Body>();
+        ball->SetInitialPosition((int)((i % columns) * ballSpacing) + BallRadius,
+                                 top + (int)((i / columns) * ballSpacing));
+        ball->Circle(BallRadius);
+        ball->SetImage(imagesDir + L"/ball1.png");
+        ball->SetDynamic();
+        machine->AddComponent(ball);
+    }
+
+    for (int chain = 0; chain < parameters.chains; chain++)
+    {
+        int x = -ShelfThickness - chain * ChainSpacing - ChainSpacing / 2;
+
+        auto hamster = std::make_shared<Hamster>(imagesDir);
+        hamster->SetInitiallyRunning(true);
+        hamster->SetPosition(x, 130);
+        hamster->SetSpeed(-1);
+        machine->AddComponent(hamster);
+
+        auto conveyor = std::make_shared<Conveyor>(imagesDir);
+        conveyor->SetPosition(x + 40, 225);
+        machine->AddComponent(conveyor);
+
+        auto drive = std::make_shared<Pulley>(25);
+        drive->SetImage(imagesDir + L"/pulley3.png");
+        drive->SetPosition(hamster->GetShaftPosition().m_x, hamster->GetShaftPosition().m_y);
+        machine->AddComponent(drive);
+
+        auto driven = std::make_shared<Pulley>(12);
+        driven->SetImage(imagesDir + L"/pulley3.png");
+        driven->SetPosition(conveyor->GetShaftPosition().m_x, conveyor->GetShaftPosition().m_y);
+        machine->AddComponent(driven);
+
+        hamster->GetSource()->Connect(hamster->GetSource(), drive->GetSink(), 1);
+        drive->GetSource()->Connect(drive->GetSource(), driven->GetSink(), drive->GetRadius() / driven->GetRadius());
+        driven->GetSource()->Connect(driven->GetSource(), conveyor->GetSink(), 1);
+        drive->SetOtherPulley(driven);
+        driven->SetOtherPulley(drive);
+    }
+
+    return machine;
+}
+
+/**
+ * Get every image a stress machine uses
+ * @param resourcesDir Directory holding images for components created
+ * @return Image file names
+ */
+std::vector<std::wstring> StressFactory::Assets(const std::wstring &resourcesDir)
+{
+    auto imagesDir = resourcesDir + ImagesDirectory;
+
+    std::vector<std::wstring> assets;
+    for (const auto& image : BodyImages)
+    {
+        assets.push_back(imagesDir + image);
+    }
+
+    DominoChain::Assets(resourcesDir, assets);
+    Hamster::Assets(imagesDir, assets);
+    Conveyor::Assets(imagesDir, assets);
+
+    return assets;
+}
+
+/**
+ * Choose parameters for a machine with about a given number of bodies
+ *
+ * A fifth of the bodies are balls, there is a chain for every
+ * thousand bodies, and the rest are dominoes in a roughly
+ * square block of rows.
+ * @param bodies Number of physics bodies wanted
+ * @param density How closely dominoes and balls are packed
+ * @return Parameters
+ */
+StressFactory::Parameters StressFactory::ForBodies(int bodies, double density)
+{
+    Parameters parameters;
+    parameters.density = density;
+    parameters.chains = std::min(MaxChains, std::max(1, bodies / BodiesPerChain));
+    parameters.balls = (int)(bodies * BallFraction);
+
+    // Each chain has a cage and a belt body, and the floor and shelves
+    // are merged into one static body
+    int dominoes = std::max(1, bodies - parameters.balls - parameters.chains * 2 - 1);
+    parameters.dominoRows = std::max(1, (int)std::sqrt(dominoes / 10.0));
+    parameters.dominoesPerRow = std::max(1, dominoes / parameters.dominoRows);
+
+    return parameters;
+}
+
+/**
+ * Get the number of physics bodies a stress machine will have
+ *
+ * The floor and shelves count as one, since the machine merges
+ * static bodies.
+ * @param parameters What the machine contains
+ * @return Body count
+ */
+int StressFactory::BodyCount(const Parameters &parameters)
+{
+    int dominoes = parameters.dominoRows * parameters.dominoesPerRow;
+    return 1 + dominoes + parameters.balls + parameters.chains * 2;
+}
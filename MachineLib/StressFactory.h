@@ -0,0 +1,55 @@
+/**
+ * @file StressFactory.h
+ * @author djmik
+ *
+ * Generates large machines for measuring how the simulator scales
+ */
+
+#ifndef CANADIANEXPERIENCE_MACHINELIB_STRESSFACTORY_H
+#define CANADIANEXPERIENCE_MACHINELIB_STRESSFACTORY_H
+
+class Machine;
+
+/**
+ * Stress machine factory class
+ *
+ * Builds machines from a few parameters: shelves of dominoes, a
+ * grid of balls that rains down onto them, and hamster, pulley and
+ * conveyor chains like those in machine 2. The same parameters
+ * always produce the same machine.
+ */
+class StressFactory
+{
+public:
+    /**
+     * What a stress machine contains
+     */
+    struct Parameters
+    {
+        /// Number of rows of dominoes, each on its own shelf
+        int dominoRows = 4;
+
+        /// Number of dominoes in each row
+        int dominoesPerRow = 25;
+
+        /// Number of balls dropped onto the dominoes
+        int balls = 20;
+
+        /// Number of hamster, pulley and conveyor chains
+        int chains = 1;
+
+        /// How closely dominoes and balls are packed. 1 spaces dominoes
+        /// so each one topples the next, larger values pack them tighter.
+        double density = 1;
+    };
+
+    static std::shared_ptr<Machine> Create(const std::wstring& resourcesDir, const Parameters& parameters);
+
+    static std::vector<std::wstring> Assets(const std::wstring& resourcesDir);
+
+    static Parameters ForBodies(int bodies, double density = 1);
+
+    static int BodyCount(const Parameters& parameters);
+};
+
+#endif //CANADIANEXPERIENCE_MACHINELIB_STRESSFACTORY_H
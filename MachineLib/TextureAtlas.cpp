@@ -0,0 +1,553 @@
+/**
+ * @file TextureAtlas.cpp
+ * @author djmik
+ */
+
+#include "pch.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "TextureAtlas.h"
+#include "ImageCache.h"
+#include "Trace.h"
+
+/// Pixels around each image filled with copies of its edge, so
+/// filtering at the edge of a sub-bitmap never picks up a neighbour
+const int AtlasPadding = 2;
+
+/// Packed pages
+std::vector<TextureAtlas::Page> TextureAtlas::mPages;
+
+/// Packed images by file name and level
+std::map<std::pair<std::wstring, int>, TextureAtlas::Entry> TextureAtlas::mEntries;
+
+/// Masked images by file name, level and mask
+std::map<std::tuple<std::wstring, int, std::wstring>, TextureAtlas::Masked> TextureAtlas::mMasked;
+
+/// Protects mPages, mEntries and mMasked
+std::mutex TextureAtlas::mMutex;
+
+/// Mask points are rounded to this fraction of the image when
+/// deciding whether two polygons have the same shape
+const double MaskPrecision = 4096;
+
+/// Width and maximum height of a page in pixels
+int TextureAtlas::mPageSize = 2048;
+
+/**
+ * Pack images into the atlas
+ *
+ * Images already in the atlas are skipped. The rest are packed tallest
+ * first onto shelves, which keeps the wasted space on each shelf small.
+ * Images too large for a page, or that cannot be loaded, are left out
+ * and drawn on their own. The layout only depends on the images and
+ * their order.
+ * @param filenames Image files to pack, loaded through ImageCache
+ * along with their levels
+ */
+void TextureAtlas::Add(const std::vector<std::wstring> &filenames)
+{
+    TRACE_SCOPE("pack atlas", "image");
+
+    typedef std::pair<std::wstring, int> Key;
+    std::vector<std::wstring> missing;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (const auto& filename : filenames)
+        {
+            if (mEntries.find(Key(filename, 0)) == mEntries.end() &&
+                std::find(missing.begin(), missing.end(), filename) == missing.end())
+            {
+                missing.push_back(filename);
+            }
+        }
+    }
+
+    // Decoding and downscaling happen without the lock, so drawing
+    // from the atlas is not held up while a machine builds
+    std::vector<std::pair<Key, std::shared_ptr<wxImage>>> added;
+    for (const auto& filename : missing)
+    {
+        auto image = ImageCache::Load(filename);
+        if (image == nullptr || !image->IsOk())
+        {
+            continue;
+        }
+
+        auto levels = ImageCache::GetLevelCount(image->GetSize());
+        for (int level = 0; level < levels; level++)
+        {
+            auto levelImage = ImageCache::LoadLevel(filename, level);
+            if (levelImage != nullptr)
+            {
+                added.push_back({Key(filename, level), levelImage});
+            }
+        }
+    }
+
+    std::stable_sort(added.begin(), added.end(), [](const auto& a, const auto& b) {
+        return a.second->GetHeight() > b.second->GetHeight();
+    });
+
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    // Images only go on the last page, which needs its pixels back
+    // first if they were released
+    if (!added.empty() && !mPages.empty())
+    {
+        RestorePixels(lock, (int)mPages.size() - 1);
+    }
+
+    for (const auto& [key, image] : added)
+    {
+        // Another thread may have packed it while we were decoding
+        if (mEntries.find(key) != mEntries.end())
+        {
+            continue;
+        }
+
+        int width = image->GetWidth() + AtlasPadding * 2;
+        int height = image->GetHeight() + AtlasPadding * 2;
+        if (width > mPageSize || height > mPageSize)
+        {
+            continue;
+        }
+
+        // Only the last page is open. Start a new shelf when this
+        // one is full and a new page when the shelves are.
+        if (mPages.empty() || mPages.back().width != mPageSize)
+        {
+            mPages.emplace_back();
+            mPages.back().width = mPageSize;
+        }
+
+        auto* page = &mPages.back();
+        if (page->shelfX + width > page->width)
+        {
+            page->shelfY += page->shelfHeight;
+            page->shelfX = 0;
+            page->shelfHeight = 0;
+        }
+
+        if (page->shelfY + height > mPageSize)
+        {
+            mPages.emplace_back();
+            page = &mPages.back();
+            page->width = mPageSize;
+        }
+
+        int x = page->shelfX;
+        int y = page->shelfY;
+        page->shelfX += width;
+        page->shelfHeight = std::max(page->shelfHeight, height);
+
+        // Pages are always full width but only as tall as their shelves
+        if (y + height > page->height)
+        {
+            page->height = y + height;
+        }
+        page->rgb.resize(page->width * page->height * 3, 0);
+        page->alpha.resize(page->width * page->height, 0);
+
+        Entry entry;
+        entry.region.page = (int)mPages.size() - 1;
+        entry.region.rect = wxRect(x + AtlasPadding, y + AtlasPadding, image->GetWidth(), image->GetHeight());
+
+        Place(*page, entry.region.rect, *image);
+        page->images.push_back(key);
+        page->dirty = true;
+        mEntries[key] = entry;
+    }
+}
+
+/**
+ * Copy an image onto a page with its edges extended into the padding
+ * @param page Page to copy to
+ * @param rect Where the image goes on the page
+ * @param image Image to copy. Taken by value since an alpha channel may be added.
+ */
+void TextureAtlas::Place(Page &page, const wxRect &rect, wxImage image)
+{
+    // Images with a mask color get an alpha channel instead
+    if (!image.HasAlpha())
+    {
+        image.InitAlpha();
+    }
+
+    int width = image.GetWidth();
+    int height = image.GetHeight();
+    const unsigned char* rgb = image.GetData();
+    const unsigned char* alpha = image.GetAlpha();
+
+    for (int row = -AtlasPadding; row < height + AtlasPadding; row++)
+    {
+        int sy = std::clamp(row, 0, height - 1);
+        int py = rect.y + row;
+        for (int col = -AtlasPadding; col < width + AtlasPadding; col++)
+        {
+            int sx = std::clamp(col, 0, width - 1);
+            int px = rect.x + col;
+
+            int source = sy * width + sx;
+            int dest = py * page.width + px;
+            std::memcpy(&page.rgb[dest * 3], &rgb[source * 3], 3);
+            page.alpha[dest] = alpha[source];
+        }
+    }
+}
+
+/**
+ * Rebuild the pixels of a page whose pixels were released
+ *
+ * The images are loaded through ImageCache, which decodes them again
+ * if they were released there as well. That is done with the lock
+ * released, so drawing is not held up; the lock is held again to copy
+ * the pixels onto the page. Does nothing if the page has its pixels.
+ * @param lock Lock on mMutex, held on entry and on return
+ * @param index Page to rebuild. Pages may have been cleared on return,
+ * so callers look up anything they need again.
+ */
+void TextureAtlas::RestorePixels(std::unique_lock<std::mutex> &lock, int index)
+{
+    while (index < (int)mPages.size() && mPages[index].rgb.empty() && !mPages[index].images.empty())
+    {
+        std::vector<std::pair<std::wstring, int>> keys = mPages[index].images;
+        std::vector<wxRect> rects;
+        for (const auto& key : keys)
+        {
+            rects.push_back(mEntries[key].region.rect);
+        }
+
+        lock.unlock();
+        std::vector<std::shared_ptr<wxImage>> images;
+        for (const auto& key : keys)
+        {
+            images.push_back(ImageCache::LoadLevel(key.first, key.second));
+        }
+        lock.lock();
+
+        // Another thread may have restored or changed the page meanwhile
+        if (index >= (int)mPages.size() || !mPages[index].rgb.empty() || mPages[index].images != keys)
+        {
+            continue;
+        }
+
+        auto& page = mPages[index];
+        page.rgb.assign(page.width * page.height * 3, 0);
+        page.alpha.assign(page.width * page.height, 0);
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            if (images[i] != nullptr)
+            {
+                Place(page, rects[i], *images[i]);
+            }
+        }
+    }
+}
+
+/**
+ * Create an image of a page's pixels
+ *
+ * Pixels that were released must be restored with RestorePixels first.
+ * @param page Page
+ * @return Page image
+ */
+wxImage TextureAtlas::PageImage(Page &page)
+{
+    if (page.rgb.empty())
+    {
+        page.rgb.assign(page.width * page.height * 3, 0);
+        page.alpha.assign(page.width * page.height, 0);
+    }
+
+    wxImage image(page.width, page.height, false);
+    std::memcpy(image.GetData(), page.rgb.data(), page.rgb.size());
+    image.SetAlpha();
+    std::memcpy(image.GetAlpha(), page.alpha.data(), page.alpha.size());
+    return image;
+}
+
+/**
+ * Find where an image was placed
+ * @param filename Image file
+ * @param region Set to the image's region if found
+ * @param level Image level
+ * @return true if the image is in the atlas
+ */
+bool TextureAtlas::Find(const std::wstring &filename, Region &region, int level)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto found = mEntries.find({filename, level});
+    if (found == mEntries.end())
+    {
+        return false;
+    }
+
+    region = found->second.region;
+    return true;
+}
+
+/**
+ * Get the bitmap to draw for an image
+ *
+ * Every polygon using the same image gets the same sub-bitmap.
+ * @param graphics Graphics context the bitmap will be drawn on
+ * @param filename Image file
+ * @param level Image level
+ * @return Sub-bitmap of the image's page, or a null bitmap if the
+ * image is not in the atlas
+ */
+wxGraphicsBitmap TextureAtlas::GetBitmap(std::shared_ptr<wxGraphicsContext> graphics,
+                                         const std::wstring &filename, int level)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    auto found = mEntries.find({filename, level});
+    if (found == mEntries.end())
+    {
+        return wxGraphicsBitmap();
+    }
+
+    auto renderer = graphics->GetRenderer();
+    if (!found->second.bitmap.IsNull() && found->second.renderer == renderer)
+    {
+        return found->second.bitmap;
+    }
+
+    // Sub-bitmaps made earlier keep the old page bitmap alive, and
+    // their part of the page never changes, so only new requests
+    // need the page recreated
+    auto stale = [renderer](const Page& page) {
+        return page.dirty || page.renderer != renderer || page.bitmap.IsNull();
+    };
+
+    if (stale(mPages[found->second.region.page]))
+    {
+        RestorePixels(lock, found->second.region.page);
+
+        found = mEntries.find({filename, level});
+        if (found == mEntries.end())
+        {
+            return wxGraphicsBitmap();
+        }
+    }
+
+    auto& entry = found->second;
+    auto& page = mPages[entry.region.page];
+    if (stale(page))
+    {
+        page.bitmap = graphics->CreateBitmapFromImage(PageImage(page));
+        page.renderer = renderer;
+        page.dirty = false;
+
+        if (ImageCache::GetPolicy() == ImageCache::Policy::Release)
+        {
+            std::vector<unsigned char>().swap(page.rgb);
+            std::vector<unsigned char>().swap(page.alpha);
+        }
+    }
+
+    auto& rect = entry.region.rect;
+    entry.bitmap = graphics->CreateSubBitmap(page.bitmap, rect.x, rect.y, rect.width, rect.height);
+    entry.renderer = renderer;
+    return entry.bitmap;
+}
+
+/**
+ * Get the bitmap to draw for an image clipped to a polygon
+ *
+ * The mask is baked into the bitmap's alpha channel, so the bitmap
+ * can be drawn without clipping. Polygons with the same image, level
+ * and shape get the same bitmap.
+ * @param graphics Graphics context the bitmap will be drawn on
+ * @param filename Image file
+ * @param level Image level
+ * @param mask Polygon in image coordinates scaled to 0-1, with 0,0 the
+ * top left of the image
+ * @return Masked bitmap, or a null bitmap if the image cannot be loaded
+ */
+wxGraphicsBitmap TextureAtlas::GetMaskedBitmap(std::shared_ptr<wxGraphicsContext> graphics,
+                                               const std::wstring &filename, int level,
+                                               const std::vector<wxPoint2DDouble> &mask)
+{
+    std::wstring shape;
+    for (auto point : mask)
+    {
+        shape += std::to_wstring(std::lround(point.m_x * MaskPrecision)) + L"," +
+                 std::to_wstring(std::lround(point.m_y * MaskPrecision)) + L";";
+    }
+
+    auto key = std::make_tuple(filename, level, shape);
+    auto renderer = graphics->GetRenderer();
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto found = mMasked.find(key);
+        if (found != mMasked.end() && !found->second.bitmap.IsNull() && found->second.renderer == renderer)
+        {
+            return found->second.bitmap;
+        }
+    }
+
+    // Decoding and masking happen without the lock
+    auto image = ImageCache::LoadLevel(filename, level);
+    if (image == nullptr || !image->IsOk())
+    {
+        return wxGraphicsBitmap();
+    }
+
+    // The image is shared, so only the copy is masked. The copy is
+    // dropped once the bitmap exists and made again if needed.
+    wxImage copy = image->Copy();
+    ApplyMask(copy, mask);
+    auto bitmap = graphics->CreateBitmapFromImage(copy);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto& masked = mMasked[key];
+    masked.bitmap = bitmap;
+    masked.renderer = renderer;
+    return masked.bitmap;
+}
+
+/**
+ * Drop the masked bitmaps kept for sharing
+ *
+ * Polygons keep the bitmap they draw, so this only stops bitmaps for
+ * polygons that are gone, such as those of a previous machine, from
+ * being kept. A polygon that needs a new bitmap makes the masked
+ * copy again.
+ * @return Number of masked bitmaps dropped
+ */
+size_t TextureAtlas::Trim()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto count = mMasked.size();
+    mMasked.clear();
+    return count;
+}
+
+/**
+ * Get the number of masked bitmaps kept for sharing
+ * @return Masked bitmap count
+ */
+size_t TextureAtlas::GetMaskedCount()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mMasked.size();
+}
+
+/**
+ * Make every pixel outside a polygon transparent
+ *
+ * A pixel is inside if its center is, using the even-odd rule, which
+ * matches clipping the image to a region made from the same polygon.
+ * @param image Image to mask. An alpha channel is added if needed.
+ * @param mask Polygon in image coordinates scaled to 0-1, with 0,0 the
+ * top left of the image
+ */
+void TextureAtlas::ApplyMask(wxImage &image, const std::vector<wxPoint2DDouble> &mask)
+{
+    if (!image.HasAlpha())
+    {
+        image.InitAlpha();
+    }
+
+    int width = image.GetWidth();
+    int height = image.GetHeight();
+    unsigned char* alpha = image.GetAlpha();
+
+    std::vector<wxPoint2DDouble> points;
+    for (auto point : mask)
+    {
+        points.emplace_back(point.m_x * width, point.m_y * height);
+    }
+
+    std::vector<double> crossings;
+    for (int row = 0; row < height; row++)
+    {
+        // Where the edges cross the middle of this row
+        double y = row + 0.5;
+        crossings.clear();
+        for (size_t i = 0; i < points.size(); i++)
+        {
+            auto& a = points[i];
+            auto& b = points[(i + 1) % points.size()];
+            if ((a.m_y <= y) != (b.m_y <= y))
+            {
+                crossings.push_back(a.m_x + (y - a.m_y) * (b.m_x - a.m_x) / (b.m_y - a.m_y));
+            }
+        }
+        std::sort(crossings.begin(), crossings.end());
+
+        // Clear everything between pairs of crossings that is outside
+        unsigned char* line = alpha + (size_t)row * width;
+        int col = 0;
+        for (size_t i = 0; i + 1 < crossings.size(); i += 2)
+        {
+            int enter = std::clamp((int)std::ceil(crossings[i] - 0.5), 0, width);
+            int leave = std::clamp((int)std::ceil(crossings[i + 1] - 0.5), 0, width);
+            std::fill(line + col, line + std::max(col, enter), 0);
+            col = std::max(col, leave);
+        }
+        std::fill(line + col, line + width, 0);
+    }
+}
+
+/**
+ * Get a copy of a page as an image
+ * @param page Page index
+ * @return Page image, or an invalid image if there is no such page
+ */
+wxImage TextureAtlas::GetPageImage(int page)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (page >= 0)
+    {
+        RestorePixels(lock, page);
+    }
+
+    if (page < 0 || page >= (int)mPages.size())
+    {
+        return wxImage();
+    }
+
+    return PageImage(mPages[page]);
+}
+
+/**
+ * Get the memory used by page pixels that have not been released
+ * @return Bytes of pixel data
+ */
+size_t TextureAtlas::GetMemory()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    size_t bytes = 0;
+    for (const auto& page : mPages)
+    {
+        bytes += page.rgb.size() + page.alpha.size();
+    }
+
+    return bytes;
+}
+
+/**
+ * Remove every image from the atlas
+ *
+ * Polygons already holding a sub-bitmap keep drawing it.
+ */
+void TextureAtlas::Clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEntries.clear();
+    mPages.clear();
+    mMasked.clear();
+}
+
+/**
+ * Set the page size used for images packed from now on
+ * @param size Width and maximum height of a page in pixels
+ */
+void TextureAtlas::SetPageSize(int size)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mPageSize = size;
+}
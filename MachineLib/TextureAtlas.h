@@ -0,0 +1,176 @@
+/**
+ * @file TextureAtlas.h
+ * @author djmik
+ *
+ * Packs machine images into a few large pages
+ */
+
+#ifndef CANADIANEXPERIENCE_MACHINELIB_TEXTUREATLAS_H
+#define CANADIANEXPERIENCE_MACHINELIB_TEXTUREATLAS_H
+
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+/**
+ * Texture atlas class
+ *
+ * Images declared by the machine factories are packed onto a few
+ * large pages using shelf packing. Each page becomes one graphics
+ * bitmap, and every polygon using an image draws from a sub-bitmap of
+ * that page, so a machine creates a handful of bitmaps instead of one
+ * per polygon. Every level ImageCache makes of an image is packed
+ * as well, so polygons drawn small use a small region.
+ *
+ * Like ImageCache this is shared by every machine and images are named
+ * by file. Images may be added from worker threads; bitmaps are only
+ * created on the drawing thread.
+ *
+ * Under the ImageCache Release policy a page's pixels are freed once
+ * its bitmap exists. They are rebuilt from the image files if the page
+ * is needed again, such as when images are added or the renderer changes.
+ *
+ * Polygons that are not rectangles draw a copy of their image with
+ * everything outside the polygon made transparent. These masked
+ * copies are not packed; each distinct image, level and mask gets one
+ * bitmap shared by every polygon with the same shape. Trim drops them
+ * once the polygons that draw them have their own reference.
+ */
+class TextureAtlas
+{
+public:
+    /**
+     * Where an image was placed in the atlas
+     */
+    struct Region
+    {
+        /// Page the image is on
+        int page = -1;
+
+        /// Location and size of the image on the page in pixels
+        wxRect rect;
+    };
+
+private:
+    /**
+     * One page of packed images
+     */
+    struct Page
+    {
+        /// Width of the page in pixels
+        int width = 0;
+
+        /// Height of the page in pixels. Pages grow as shelves are added.
+        int height = 0;
+
+        /// RGB pixel data, empty if released
+        std::vector<unsigned char> rgb;
+
+        /// Alpha pixel data, empty if released
+        std::vector<unsigned char> alpha;
+
+        /// Images and levels placed on this page
+        std::vector<std::pair<std::wstring, int>> images;
+
+        /// Top of the shelf currently being filled
+        int shelfY = 0;
+
+        /// Height of the shelf currently being filled
+        int shelfHeight = 0;
+
+        /// Left of the next image on the current shelf
+        int shelfX = 0;
+
+        /// Bitmap of the whole page
+        wxGraphicsBitmap bitmap;
+
+        /// Renderer the page bitmap was created with
+        wxGraphicsRenderer* renderer = nullptr;
+
+        /// Set when images were added after the bitmap was created
+        bool dirty = true;
+    };
+
+    /**
+     * An image that has been packed
+     */
+    struct Entry
+    {
+        /// Where the image was placed
+        Region region;
+
+        /// Sub-bitmap polygons draw
+        wxGraphicsBitmap bitmap;
+
+        /// Renderer the sub-bitmap was created with
+        wxGraphicsRenderer* renderer = nullptr;
+    };
+
+    /**
+     * A masked copy of an image
+     */
+    struct Masked
+    {
+        /// Bitmap of the masked image
+        wxGraphicsBitmap bitmap;
+
+        /// Renderer the bitmap was created with
+        wxGraphicsRenderer* renderer = nullptr;
+    };
+
+    /// Packed pages
+    static std::vector<Page> mPages;
+
+    /// Packed images by file name and level
+    static std::map<std::pair<std::wstring, int>, Entry> mEntries;
+
+    /// Masked images by file name, level and mask
+    static std::map<std::tuple<std::wstring, int, std::wstring>, Masked> mMasked;
+
+    /// Protects mPages, mEntries and mMasked
+    static std::mutex mMutex;
+
+    /// Width and maximum height of a page in pixels
+    static int mPageSize;
+
+    static void Place(Page& page, const wxRect& rect, wxImage image);
+
+    static void RestorePixels(std::unique_lock<std::mutex>& lock, int index);
+
+    static wxImage PageImage(Page& page);
+
+public:
+    static void Add(const std::vector<std::wstring>& filenames);
+
+    static bool Find(const std::wstring& filename, Region& region, int level = 0);
+
+    static wxGraphicsBitmap GetBitmap(std::shared_ptr<wxGraphicsContext> graphics,
+                                      const std::wstring& filename, int level = 0);
+
+    static wxGraphicsBitmap GetMaskedBitmap(std::shared_ptr<wxGraphicsContext> graphics,
+                                            const std::wstring& filename, int level,
+                                            const std::vector<wxPoint2DDouble>& mask);
+
+    static void ApplyMask(wxImage& image, const std::vector<wxPoint2DDouble>& mask);
+
+    static wxImage GetPageImage(int page);
+
+    static size_t GetMemory();
+
+    static void Clear();
+
+    static size_t Trim();
+
+    static size_t GetMaskedCount();
+
+    static void SetPageSize(int size);
+
+    /**
+     * Get the number of pages in use
+     * @return Page count
+     */
+    static size_t GetPageCount() { std::lock_guard<std::mutex> lock(mMutex); return mPages.size(); }
+};
+
+#endif //CANADIANEXPERIENCE_MACHINELIB_TEXTUREATLAS_H
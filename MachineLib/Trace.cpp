@@ -0,0 +1,256 @@
+/**
+ * @file Trace.cpp
+ * @author djmik
+ */
+
+#include "pch.h"
+#include <wx/file.h>
+#include <sstream>
+#include "Trace.h"
+
+#ifdef __GNUG__
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
+
+/// Buffer of every thread that has recorded an event
+std::vector<std::shared_ptr<Trace::Buffer>> Trace::mBuffers;
+
+/// Protects mBuffers
+std::mutex Trace::mMutex;
+
+/// Is recording on?
+std::atomic<bool> Trace::mEnabled{false};
+
+/// Events each thread buffer holds
+size_t Trace::mCapacity = 65536;
+
+/// Generation of buffers, so threads notice a restart
+std::atomic<int> Trace::mGeneration{0};
+
+/// When the trace started
+std::chrono::steady_clock::time_point Trace::mStart;
+
+/**
+ * Start recording, discarding any earlier events
+ *
+ * Call while no events are being recorded.
+ * @param capacity Events each thread can record
+ */
+void Trace::Start(size_t capacity)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEnabled = false;
+    mBuffers.clear();
+    mCapacity = capacity;
+    mStart = std::chrono::steady_clock::now();
+    mGeneration++;
+    mEnabled = true;
+}
+
+/**
+ * Stop recording. Recorded events are kept until the next Start.
+ */
+void Trace::Stop()
+{
+    mEnabled = false;
+}
+
+/**
+ * Get the buffer for the calling thread, creating it the first
+ * time the thread records since the trace started
+ * @return Buffer
+ */
+Trace::Buffer* Trace::ThreadBuffer()
+{
+    // Shared so a buffer outlives its thread until it is saved,
+    // and outlives the trace while its thread is still writing
+    thread_local std::shared_ptr<Buffer> buffer;
+    thread_local int generation = -1;
+
+    if (buffer == nullptr || generation != mGeneration)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        buffer = std::make_shared<Buffer>();
+        buffer->thread = (int)mBuffers.size() + 1;
+        buffer->capacity = mCapacity;
+        buffer->events.reset(new Event[mCapacity]);
+        generation = mGeneration;
+        mBuffers.push_back(buffer);
+    }
+
+    return buffer.get();
+}
+
+/**
+ * Record a completed event on the calling thread
+ * @param name Event name
+ * @param category Event category
+ * @param detail Extra detail or nullptr
+ * @param begin When the event began
+ * @param end When the event ended
+ */
+void Trace::Record(const char *name, const char *category, const char *detail,
+                   std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end)
+{
+    auto buffer = ThreadBuffer();
+
+    // Only this thread writes the count, so it cannot change under us
+    auto count = buffer->count.load(std::memory_order_relaxed);
+    if (count >= buffer->capacity)
+    {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    auto& event = buffer->events[count];
+    event.name = name;
+    event.category = category;
+    event.detail = detail;
+    event.start = duration_cast<microseconds>(begin - mStart).count();
+    event.duration = duration_cast<microseconds>(end - begin).count();
+
+    // Publish the event to readers
+    buffer->count.store(count + 1, std::memory_order_release);
+}
+
+/**
+ * Get the number of events recorded since the trace started
+ * @return Event count
+ */
+size_t Trace::GetCount()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    size_t count = 0;
+    for (const auto& buffer : mBuffers)
+    {
+        count += buffer->count.load(std::memory_order_acquire);
+    }
+    return count;
+}
+
+/**
+ * Get the number of events that did not fit in their thread's buffer
+ * @return Dropped event count
+ */
+size_t Trace::GetDropped()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    size_t dropped = 0;
+    for (const auto& buffer : mBuffers)
+    {
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    return dropped;
+}
+
+/**
+ * Get a readable class name from a typeid name
+ * @param typeName Name from std::type_info::name
+ * @return Class name
+ */
+std::string Trace::ReadableName(const char *typeName)
+{
+#ifdef __GNUG__
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(typeName, nullptr, nullptr, &status);
+    if (status == 0 && demangled != nullptr)
+    {
+        std::string result(demangled);
+        std::free(demangled);
+        return result;
+    }
+#endif
+
+    // MSVC names are already readable, apart from the prefix
+    std::string result(typeName);
+    if (result.compare(0, 6, "class ") == 0)
+    {
+        result.erase(0, 6);
+    }
+    return result;
+}
+
+/**
+ * Write a string as a JSON string literal
+ * @param str Stream to write to
+ * @param text Text to write
+ */
+static void JsonString(std::ostringstream& str, const std::string& text)
+{
+    str << '"';
+    for (auto c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            str << '\\';
+        }
+        str << c;
+    }
+    str << '"';
+}
+
+/**
+ * Get the recorded events in Chrome trace format
+ *
+ * Events still being recorded by other threads are included as far
+ * as they have been published.
+ * @return JSON text
+ */
+std::string Trace::ToJson()
+{
+    std::ostringstream str;
+    str << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    bool first = true;
+    for (const auto& buffer : mBuffers)
+    {
+        if (!first)
+        {
+            str << ",";
+        }
+        first = false;
+
+        str << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->thread
+            << ",\"args\":{\"name\":\"thread " << buffer->thread << "\"}}";
+
+        auto count = buffer->count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; i++)
+        {
+            const auto& event = buffer->events[i];
+            str << ",\n{\"name\":";
+            JsonString(str, event.name);
+            str << ",\"cat\":";
+            JsonString(str, event.category);
+            str << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread
+                << ",\"ts\":" << event.start << ",\"dur\":" << event.duration;
+            if (event.detail != nullptr)
+            {
+                str << ",\"args\":{\"type\":";
+                JsonString(str, ReadableName(event.detail));
+                str << "}";
+            }
+            str << "}";
+        }
+    }
+
+    str << "\n]}\n";
+    return str.str();
+}
+
+/**
+ * Save the recorded events as a Chrome trace file
+ * @param filename File to write
+ * @return true if successful
+ */
+bool Trace::Save(const std::wstring &filename)
+{
+    auto json = ToJson();
+
+    wxFile file;
+    return file.Create(filename, true) && file.Write(json.data(), json.size()) == json.size();
+}
@@ -0,0 +1,184 @@
+/**
+ * @file Trace.h
+ * @author djmik
+ *
+ * Timeline of scoped events exported in Chrome trace format
+ */
+
+#ifndef CANADIANEXPERIENCE_MACHINELIB_TRACE_H
+#define CANADIANEXPERIENCE_MACHINELIB_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Trace class
+ *
+ * Records named, timed events from any thread and saves them as a
+ * Chrome trace file that chrome://tracing, Perfetto and similar
+ * viewers show as a timeline.
+ *
+ * Each thread writes to its own fixed size buffer without locking.
+ * Events past the end of a buffer are dropped and counted. Names
+ * must be string literals or otherwise outlive the trace, since only
+ * the pointer is kept.
+ *
+ * Recording is off until Start is called. While off, a scope costs
+ * one test of a flag.
+ */
+class Trace
+{
+private:
+    /**
+     * One completed event
+     */
+    struct Event
+    {
+        /// Event name
+        const char* name;
+
+        /// Event category
+        const char* category;
+
+        /// Extra detail, a type name from typeid, or nullptr
+        const char* detail;
+
+        /// Start in microseconds since the trace started
+        int64_t start;
+
+        /// Duration in microseconds
+        int64_t duration;
+    };
+
+    /**
+     * Events recorded by one thread
+     */
+    struct Buffer
+    {
+        /// Thread number within the trace
+        int thread = 0;
+
+        /// Event storage
+        std::unique_ptr<Event[]> events;
+
+        /// Size of events
+        size_t capacity = 0;
+
+        /// Number of events written. Events below this are complete.
+        std::atomic<size_t> count{0};
+
+        /// Events that did not fit
+        std::atomic<size_t> dropped{0};
+    };
+
+    /// Buffer of every thread that has recorded an event
+    static std::vector<std::shared_ptr<Buffer>> mBuffers;
+
+    /// Protects mBuffers. Only taken the first time a thread records.
+    static std::mutex mMutex;
+
+    /// Is recording on?
+    static std::atomic<bool> mEnabled;
+
+    /// Events each thread buffer holds
+    static size_t mCapacity;
+
+    /// Generation of buffers, so threads notice a restart
+    static std::atomic<int> mGeneration;
+
+    /// When the trace started
+    static std::chrono::steady_clock::time_point mStart;
+
+    static Buffer* ThreadBuffer();
+
+public:
+    /**
+     * A scoped event, recorded from construction to destruction
+     */
+    class Scope
+    {
+    private:
+        /// Event name, nullptr if not recording
+        const char* mName = nullptr;
+
+        /// Event category
+        const char* mCategory;
+
+        /// Extra detail
+        const char* mDetail;
+
+        /// When the scope began
+        std::chrono::steady_clock::time_point mBegin;
+
+    public:
+        /**
+         * Constructor
+         * @param name Event name
+         * @param category Event category
+         * @param detail Extra detail, such as typeid(x).name(), or nullptr
+         */
+        Scope(const char* name, const char* category, const char* detail = nullptr)
+            : mCategory(category), mDetail(detail)
+        {
+            if (IsEnabled())
+            {
+                mName = name;
+                mBegin = std::chrono::steady_clock::now();
+            }
+        }
+
+        /**
+         * Destructor
+         */
+        ~Scope()
+        {
+            if (mName != nullptr)
+            {
+                Record(mName, mCategory, mDetail, mBegin, std::chrono::steady_clock::now());
+            }
+        }
+
+        /// Copy constructor (disabled)
+        Scope(const Scope &) = delete;
+
+        /// Assignment operator (disabled)
+        void operator=(const Scope &) = delete;
+    };
+
+    /**
+     * Is recording on?
+     * @return true if events are being recorded
+     */
+    static bool IsEnabled() { return mEnabled.load(std::memory_order_relaxed); }
+
+    static void Start(size_t capacity = 65536);
+
+    static void Stop();
+
+    static void Record(const char* name, const char* category, const char* detail,
+                       std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end);
+
+    static size_t GetCount();
+
+    static size_t GetDropped();
+
+    static bool Save(const std::wstring& filename);
+
+    static std::string ToJson();
+
+    static std::string ReadableName(const char* typeName);
+};
+
+/// Helpers so TRACE_SCOPE names are unique within a function
+#define TRACE_CONCAT_INNER(a, b) a##b
+/// Helpers so TRACE_SCOPE names are unique within a function
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+/// Record an event for the rest of the enclosing scope
+#define TRACE_SCOPE(...) Trace::Scope TRACE_CONCAT(traceScope, __LINE__)(__VA_ARGS__)
+
+#endif //CANADIANEXPERIENCE_MACHINELIB_TRACE_H
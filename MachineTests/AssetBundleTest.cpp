@@ -0,0 +1,53 @@
+/**
+ * @file AssetBundleTest.cpp
+ * @author djmik
+ */
+
+#include "pch.h"
+#include "gtest/gtest.h"
+#include <wx/filename.h>
+#include <wx/dir.h>
+#include <wx/file.h>
+
+#include <AssetBundle.h>
+
+/**
+ * Tests building a bundle and reading images back in both formats
+ */
+TEST(AssetBundleTest, RoundTrip)
+{
+    auto dir = wxFileName::CreateTempFileName(L"images");
+    wxRemoveFile(dir);
+    ASSERT_TRUE(wxMkdir(dir));
+
+    wxImage image(8, 4);
+    image.SetRGB(wxRect(0, 0, 8, 4), 10, 20, 30);
+    image.SetRGB(3, 2, 200, 100, 50);
+    ASSERT_TRUE(image.SaveFile(dir + L"/test.png", wxBITMAP_TYPE_PNG));
+
+    // Files that are not images are left out
+    wxFile(dir + L"/notes.txt", wxFile::write).Write(wxString(L"not an image"));
+
+    for (auto format : {AssetBundle::Format::Encoded, AssetBundle::Format::Raw})
+    {
+        auto filename = dir + L"/images.bundle";
+
+        AssetBundle bundle;
+        ASSERT_TRUE(bundle.Save(dir.ToStdWstring(), filename.ToStdWstring(), format));
+        ASSERT_TRUE(bundle.Open(filename.ToStdWstring()));
+        ASSERT_EQ(1, bundle.GetCount());
+        ASSERT_TRUE(bundle.Contains(L"test.png"));
+        ASSERT_EQ(nullptr, bundle.Decode(L"notes.txt"));
+
+        auto decoded = bundle.Decode(L"test.png");
+        ASSERT_NE(nullptr, decoded);
+        ASSERT_EQ(8, decoded->GetWidth());
+        ASSERT_EQ(4, decoded->GetHeight());
+        ASSERT_EQ(200, decoded->GetRed(3, 2));
+        ASSERT_EQ(30, decoded->GetBlue(0, 0));
+
+        wxRemoveFile(filename);
+    }
+
+    wxDir::Remove(dir, wxPATH_RMDIR_RECURSIVE);
+}
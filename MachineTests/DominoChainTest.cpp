@@ -0,0 +1,89 @@
+/**
+ * @file DominoChainTest.cpp
+ * @author djmik
+ */
+
+#include "pch.h"
+#include "gtest/gtest.h"
+#include <b2_world.h>
+#include <b2_body.h>
+
+#include <DominoChain.h>
+#include <Machine.h>
+
+/**
+ * Tests spacing dominoes along a path
+ */
+TEST(DominoChainTest, Layout)
+{
+    DominoChain chain(L".", 0);
+    chain.SetSpacing(10);
+    chain.AddPoint(0, 0);
+    chain.AddPoint(100, 0);
+    ASSERT_EQ(11, chain.GetCount());
+
+    // Spacing carries on around corners
+    chain.AddPoint(100, 55);
+    ASSERT_EQ(16, chain.GetCount());
+
+    DominoChain single(L".", 1);
+    single.AddPoint(10, 10);
+    ASSERT_EQ(1, single.GetCount());
+}
+
+/**
+ * Tests that every domino gets a body, and again after a reset
+ */
+TEST(DominoChainTest, Bodies)
+{
+    auto chain = std::make_shared<DominoChain>(L".", 2);
+    chain->SetSpacing(15);
+    chain->SetLean(0.02);
+    chain->SetGround(true);
+    chain->AddArc(0, 200, 200, 0.75, 1.0);
+
+    Machine machine;
+    machine.AddComponent(chain);
+
+    // One body for each domino and one for the ground
+    auto world = machine.GetWorld();
+    ASSERT_EQ(chain->GetCount() + 1, world->GetBodyCount());
+
+    int awake = 0;
+    for (auto body = world->GetBodyList(); body != nullptr; body = body->GetNext())
+    {
+        awake += body->GetType() == b2_dynamicBody && body->IsAwake() ? 1 : 0;
+    }
+    ASSERT_EQ(1, awake);
+
+    machine.Update(1.0 / 30);
+    machine.Reset();
+    ASSERT_EQ(chain->GetCount() + 1, machine.GetWorld()->GetBodyCount());
+}
+
+/**
+ * Tests that repeated path points do not make an invalid ground
+ */
+TEST(DominoChainTest, RepeatedPoints)
+{
+    auto chain = std::make_shared<DominoChain>(L".", 1);
+    chain->SetGround(true);
+    chain->AddPoint(0, 0);
+    chain->AddPoint(0, 0);
+    chain->AddPoint(100, 0);
+    chain->AddPoint(100, 0);
+
+    Machine machine;
+    machine.AddComponent(chain);
+    ASSERT_EQ(chain->GetCount() + 1, machine.GetWorld()->GetBodyCount());
+
+    // A path that never moves has no ground at all
+    auto still = std::make_shared<DominoChain>(L".", 1);
+    still->SetGround(true);
+    still->AddPoint(10, 10);
+    still->AddPoint(10, 10);
+
+    Machine other;
+    other.AddComponent(still);
+    ASSERT_EQ(still->GetCount(), other.GetWorld()->GetBodyCount());
+}
@@ -0,0 +1,262 @@
+/**
+ * @file GoldenTest.cpp
+ * @author djmik
+ *
+ * Runs the built in machines and compares their trajectories with
+ * stored golden data. Set MACHINE_UPDATE_GOLDEN in the environment
+ * to record the golden data again after an intended change in
+ * behaviour. Missing golden data is a failure.
+ */
+
+#include "pch.h"
+#include "gtest/gtest.h"
+#include <wx/filename.h>
+#include <wx/stopwatch.h>
+#include <fstream>
+#include <b2_world.h>
+#include <b2_body.h>
+
+#include <Machine1Factory.h>
+#include <Machine2Factory.h>
+#include <Machine.h>
+#include <Goal.h>
+
+/// Frames each machine is run for
+const int GoldenFrames = 600;
+
+/// Frame rate the machines are run at
+const double GoldenFrameRate = 30;
+
+/// Frames between samples compared with the golden data
+const int GoldenInterval = 30;
+
+/// Largest difference allowed in a body position in meters
+const double PositionTolerance = 0.01;
+
+/// Largest difference allowed in a body or component angle
+const double AngleTolerance = 0.01;
+
+/// Longest a machine may take to run all frames in milliseconds
+const long RuntimeBudget = 5000;
+
+/**
+ * State of a machine at one sampled frame
+ */
+struct Sample
+{
+    /// Frame the sample was taken after
+    int frame = 0;
+
+    /// Score of each goal in the order added
+    std::vector<int> scores;
+
+    /// Rotation of each component in the order added
+    std::vector<double> rotations;
+
+    /// Position and angle of each body that can move, in creation order
+    std::vector<b2Vec3> bodies;
+};
+
+/**
+ * Record the state of a machine
+ * @param machine Machine to sample
+ * @param frame Frame number
+ * @return Sample
+ */
+static Sample TakeSample(Machine& machine, int frame)
+{
+    Sample sample;
+    sample.frame = frame;
+
+    for (const auto& component : machine.GetComponents())
+    {
+        sample.rotations.push_back(component->GetRotation());
+
+        auto goal = dynamic_cast<Goal*>(component.get());
+        if (goal != nullptr)
+        {
+            sample.scores.push_back(goal->GetScore());
+        }
+    }
+
+    // Box2D lists the newest body first. Static bodies never move and
+    // may be merged into one, so only the others are compared.
+    for (auto body = machine.GetWorld()->GetBodyList(); body != nullptr; body = body->GetNext())
+    {
+        if (body->GetType() == b2_staticBody)
+        {
+            continue;
+        }
+
+        sample.bodies.insert(sample.bodies.begin(),
+                             b2Vec3(body->GetPosition().x, body->GetPosition().y, body->GetAngle()));
+    }
+
+    return sample;
+}
+
+/**
+ * Run a machine from its initial state, sampling it at intervals
+ * @param machine Machine to run
+ * @return Samples
+ */
+static std::vector<Sample> Run(Machine& machine)
+{
+    std::vector<Sample> samples;
+
+    machine.Reset();
+    for (int frame = 0; frame < GoldenFrames; frame++)
+    {
+        machine.SetCurrentTime(frame / GoldenFrameRate);
+        machine.Update(1.0 / GoldenFrameRate);
+
+        if ((frame + 1) % GoldenInterval == 0)
+        {
+            samples.push_back(TakeSample(machine, frame + 1));
+        }
+    }
+
+    return samples;
+}
+
+/**
+ * Write golden data
+ * @param filename File to write
+ * @param samples Samples to write
+ */
+static void Save(const std::string& filename, const std::vector<Sample>& samples)
+{
+    std::ofstream file(filename);
+    file.precision(9);
+    for (const auto& sample : samples)
+    {
+        file << "frame " << sample.frame << "\n";
+        for (auto score : sample.scores)
+        {
+            file << "score " << score << "\n";
+        }
+
+        for (auto rotation : sample.rotations)
+        {
+            file << "rotation " << rotation << "\n";
+        }
+
+        for (auto body : sample.bodies)
+        {
+            file << "body " << body.x << " " << body.y << " " << body.z << "\n";
+        }
+    }
+}
+
+/**
+ * Read golden data written by Save
+ * @param filename File to read
+ * @return Samples
+ */
+static std::vector<Sample> Load(const std::string& filename)
+{
+    std::vector<Sample> samples;
+    std::ifstream file(filename);
+    std::string tag;
+    while (file >> tag)
+    {
+        if (tag == "frame")
+        {
+            samples.emplace_back();
+            file >> samples.back().frame;
+        }
+        else if (tag == "score" && !samples.empty())
+        {
+            int score = 0;
+            file >> score;
+            samples.back().scores.push_back(score);
+        }
+        else if (tag == "rotation" && !samples.empty())
+        {
+            double rotation = 0;
+            file >> rotation;
+            samples.back().rotations.push_back(rotation);
+        }
+        else if (tag == "body" && !samples.empty())
+        {
+            b2Vec3 body;
+            file >> body.x >> body.y >> body.z;
+            samples.back().bodies.push_back(body);
+        }
+    }
+
+    return samples;
+}
+
+/**
+ * Run a machine and compare it with its golden data
+ * @param name Name of the golden data file without extension
+ * @param machine Machine to run
+ */
+static void CheckGolden(const std::string& name, Machine& machine)
+{
+    wxFileName filename(MACHINE_GOLDEN_DIR, name + ".txt");
+    auto path = filename.GetFullPath().ToStdString();
+
+    wxStopWatch watch;
+    auto samples = Run(machine);
+    auto time = watch.Time();
+    EXPECT_LT(time, RuntimeBudget) << name << " took " << time << " ms to run " << GoldenFrames << " frames";
+
+    if (wxGetEnv(L"MACHINE_UPDATE_GOLDEN", nullptr))
+    {
+        filename.Mkdir(wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+        Save(path, samples);
+        GTEST_SKIP() << "Recorded golden data to " << path << ", review it and run again without "
+                     << "MACHINE_UPDATE_GOLDEN to compare";
+    }
+
+    ASSERT_TRUE(filename.FileExists()) << "No golden data at " << path
+                                       << ", run with MACHINE_UPDATE_GOLDEN set to record it";
+
+    auto golden = Load(path);
+    ASSERT_EQ(golden.size(), samples.size());
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        auto& expected = golden[i];
+        auto& actual = samples[i];
+        ASSERT_EQ(expected.frame, actual.frame);
+        ASSERT_EQ(expected.scores, actual.scores) << "Scores differ at frame " << actual.frame;
+        ASSERT_EQ(expected.rotations.size(), actual.rotations.size())
+            << "Component count differs at frame " << actual.frame;
+
+        for (size_t c = 0; c < actual.rotations.size(); c++)
+        {
+            ASSERT_NEAR(expected.rotations[c], actual.rotations[c], AngleTolerance)
+                << "Component " << c << " rotation at frame " << actual.frame;
+        }
+
+        ASSERT_EQ(expected.bodies.size(), actual.bodies.size()) << "Body count differs at frame " << actual.frame;
+
+        for (size_t b = 0; b < actual.bodies.size(); b++)
+        {
+            ASSERT_NEAR(expected.bodies[b].x, actual.bodies[b].x, PositionTolerance)
+                << "Body " << b << " x at frame " << actual.frame;
+            ASSERT_NEAR(expected.bodies[b].y, actual.bodies[b].y, PositionTolerance)
+                << "Body " << b << " y at frame " << actual.frame;
+            ASSERT_NEAR(expected.bodies[b].z, actual.bodies[b].z, AngleTolerance)
+                << "Body " << b << " angle at frame " << actual.frame;
+        }
+    }
+}
+
+/**
+ * Tests the trajectory of machine 1
+ */
+TEST(GoldenTest, Machine1)
+{
+    CheckGolden("machine1", *Machine1Factory::Create(L"."));
+}
+
+/**
+ * Tests the trajectory of machine 2
+ */
+TEST(GoldenTest, Machine2)
+{
+    CheckGolden("machine2", *Machine2Factory::Create(L"."));
+}
@@ -0,0 +1,160 @@
+/**
+ * @file MachineLoaderTest.cpp
+ * @author djmik
+ */
+
+#include "pch.h"
+#include "gtest/gtest.h"
+#include <wx/sstream.h>
+#include <wx/filename.h>
+
+#include <MachineLoader.h>
+#include <MachineDescription.h>
+#include <MachineBinary.h>
+#include <StateRecorder.h>
+#include <Machine1Factory.h>
+#include <Machine2Factory.h>
+#include <Machine.h>
+
+/// A small machine using each kind of element the loader understands
+const wxString TestMachine =
+    L"<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+    L"<machine name=\"Test\">"
+    L"<body id=\"floor\" image=\"floor.png\"><rectangle x=\"-300\" y=\"0\" width=\"600\" height=\"15\"/></body>"
+    L"<body id=\"ball\" x=\"-200\" y=\"350\" image=\"ball1.png\" motion=\"dynamic\"><circle radius=\"12\"/></body>"
+    L"<hamster id=\"hamster\" x=\"10\" y=\"130\" running=\"true\" speed=\"-1.5\"/>"
+    L"<pulley id=\"pulley\" radius=\"8\" image=\"pulley3.png\" anchor=\"hamster\"/>"
+    L"<domino color=\"blue\" x=\"-100\" y=\"15\"/>"
+    L"<unknown/>"
+    L"<connect source=\"hamster\" sink=\"pulley\" ratio=\"2\"/>"
+    L"<belt first=\"pulley\" second=\"other\"/>"
+    L"</machine>";
+
+/**
+ * Tests parsing a description from XML
+ */
+TEST(MachineLoaderTest, Parse)
+{
+    wxStringInputStream stream(TestMachine);
+    MachineLoader loader;
+    auto description = loader.Parse(stream);
+
+    ASSERT_NE(nullptr, description);
+    ASSERT_EQ(L"Test", description->GetName());
+
+    auto& elements = description->GetElements();
+    ASSERT_EQ(5, elements.size());
+
+    ASSERT_EQ(MachineDescription::Type::Body, elements[0].type);
+    ASSERT_EQ(MachineDescription::Shape::Rectangle, elements[0].shape);
+    ASSERT_NEAR(600, elements[0].rectangle.m_width, 0.001);
+    ASSERT_EQ(MachineDescription::Motion::Static, elements[0].motion);
+
+    ASSERT_EQ(MachineDescription::Shape::Circle, elements[1].shape);
+    ASSERT_NEAR(12, elements[1].radius, 0.001);
+    ASSERT_NEAR(-200, elements[1].position.m_x, 0.001);
+    ASSERT_EQ(MachineDescription::Motion::Dynamic, elements[1].motion);
+
+    ASSERT_EQ(MachineDescription::Type::Hamster, elements[2].type);
+    ASSERT_TRUE(elements[2].running);
+    ASSERT_NEAR(-1.5, elements[2].speed, 0.001);
+
+    ASSERT_EQ(2, elements[3].anchor);
+    ASSERT_EQ(3, description->GetAssets().size());
+    ASSERT_EQ(2, elements[4].domino);
+
+    ASSERT_EQ(1, description->GetConnections().size());
+    ASSERT_EQ(2, description->GetConnections()[0].source);
+    ASSERT_EQ(3, description->GetConnections()[0].sink);
+    ASSERT_NEAR(2, description->GetConnections()[0].ratio, 0.001);
+
+    // The belt refers to a pulley that does not exist
+    ASSERT_EQ(1, description->GetBelts().size());
+    ASSERT_EQ(-1, description->GetBelts()[0].second);
+}
+
+/**
+ * Tests that files without a machine root are rejected
+ */
+TEST(MachineLoaderTest, NotAMachine)
+{
+    wxStringInputStream stream(L"<?xml version=\"1.0\"?><aquarium/>");
+    MachineLoader loader;
+    ASSERT_EQ(nullptr, loader.Parse(stream));
+    ASSERT_FALSE(loader.GetError().empty());
+}
+
+/**
+ * Tests that a compiled machine reads back with its physics vertices
+ */
+TEST(MachineLoaderTest, Compiled)
+{
+    wxStringInputStream stream(TestMachine);
+    MachineLoader loader;
+    auto description = loader.Parse(stream);
+    ASSERT_NE(nullptr, description);
+
+    auto filename = wxFileName::CreateTempFileName(L"machine").ToStdWstring();
+    MachineBinary binary;
+    ASSERT_TRUE(binary.Save(*description, filename));
+
+    auto compiled = binary.Read(filename);
+    wxRemoveFile(filename);
+    ASSERT_NE(nullptr, compiled);
+
+    ASSERT_EQ(description->GetAssets(), compiled->GetAssets());
+    ASSERT_EQ(description->GetElements().size(), compiled->GetElements().size());
+    ASSERT_EQ(description->GetConnections().size(), compiled->GetConnections().size());
+
+    // The floor rectangle has its vertices computed, the circle does not
+    ASSERT_EQ(4, compiled->GetElements()[0].vertices.size());
+    ASSERT_TRUE(compiled->GetElements()[1].vertices.empty());
+    ASSERT_NEAR(-1.5, compiled->GetElements()[2].speed, 0.001);
+    ASSERT_EQ(2, compiled->GetElements()[3].anchor);
+}
+
+/**
+ * Tests the images a description declares for preloading
+ */
+TEST(MachineLoaderTest, Assets)
+{
+    wxStringInputStream stream(TestMachine);
+    MachineLoader loader;
+    auto description = loader.Parse(stream);
+    ASSERT_NE(nullptr, description);
+
+    // Three body images, six hamster images and four domino colors
+    auto assets = description->ResolveAssets(L"res");
+    ASSERT_EQ(13, assets.size());
+    ASSERT_EQ(L"res/images/floor.png", assets[0]);
+    ASSERT_NE(assets.end(), std::find(assets.begin(), assets.end(), L"res/images/hamster-run-2.png"));
+    ASSERT_NE(assets.end(), std::find(assets.begin(), assets.end(), L"res/images/domino-blue.png"));
+}
+
+/**
+ * Tests that the machine files run exactly like the factories
+ * that build the same machines in code
+ */
+TEST(MachineLoaderTest, MatchesFactories)
+{
+    std::vector<std::pair<std::wstring, std::shared_ptr<Machine>>> machines = {
+        {L"machine1.xml", Machine1Factory::Create(L".")},
+        {L"machine2.xml", Machine2Factory::Create(L".")}};
+
+    for (auto& [name, factory] : machines)
+    {
+        MachineLoader loader;
+        auto loaded = loader.Load(wxFileName(MACHINE_FILES_DIR, name).GetFullPath().ToStdWstring(), L".");
+        ASSERT_NE(nullptr, loaded) << loader.GetError();
+        ASSERT_EQ(factory->GetComponentCount(), loaded->GetComponentCount()) << name;
+
+        StateRecorder expected;
+        expected.Record(*factory, 300);
+
+        StateRecorder actual;
+        actual.Record(*loaded, 300);
+
+        auto divergence = expected.Compare(actual);
+        ASSERT_FALSE(divergence.IsDivergent()) << name << ": " << StateRecorder::Describe(divergence);
+    }
+}
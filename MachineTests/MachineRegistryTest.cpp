@@ -0,0 +1,153 @@
+/**
+ * @file MachineRegistryTest.cpp
+ * @author djmik
+ */
+
+#include "pch.h"
+#include "gtest/gtest.h"
+
+#include <MachineRegistry.h>
+#include <Machine.h>
+#include <Machine1Factory.h>
+#include <Machine2Factory.h>
+
+/**
+ * Register test machines that count how often they are built
+ * @param registry Registry to add to
+ * @param builds Build counter
+ * @param count Number of machines to register
+ */
+static void RegisterTestMachines(MachineRegistry& registry, int& builds, int count)
+{
+    for (int i = 1; i <= count; i++)
+    {
+        registry.Register(i, L"Test " + std::to_wstring(i), [&builds](const std::wstring&) {
+            builds++;
+            return std::make_shared<Machine>();
+        });
+    }
+}
+
+/**
+ * Tests registering and finding machines
+ */
+TEST(MachineRegistryTest, Register)
+{
+    MachineRegistry registry;
+    int builds = 0;
+    RegisterTestMachines(registry, builds, 2);
+
+    ASSERT_TRUE(registry.IsRegistered(1));
+    ASSERT_FALSE(registry.IsRegistered(3));
+    ASSERT_EQ(L"Test 2", registry.GetName(2));
+    ASSERT_EQ(2, registry.Find(L"Test 2"));
+    ASSERT_EQ(0, registry.Find(L"Missing"));
+    ASSERT_EQ(nullptr, registry.Get(3, L"."));
+    ASSERT_EQ(0, builds);
+}
+
+/**
+ * Tests that recently used machines are reused
+ */
+TEST(MachineRegistryTest, Reuse)
+{
+    MachineRegistry registry;
+    int builds = 0;
+    RegisterTestMachines(registry, builds, 2);
+
+    auto machine1 = registry.Get(1, L".");
+    auto machine2 = registry.Get(2, L".");
+    ASSERT_EQ(2, builds);
+
+    // Switching back is a reset, not a rebuild
+    machine1->SetCurrentTime(5);
+    ASSERT_EQ(machine1, registry.Get(1, L"."));
+    ASSERT_EQ(machine2, registry.Get(2, L"."));
+    ASSERT_EQ(2, builds);
+    ASSERT_NEAR(0, machine1->GetCurrentTime(), 0.0001);
+    ASSERT_EQ(2, registry.GetHits());
+    ASSERT_EQ(2, registry.GetMisses());
+}
+
+/**
+ * Tests that the least recently used machine is evicted
+ */
+TEST(MachineRegistryTest, Eviction)
+{
+    MachineRegistry registry;
+    int builds = 0;
+    RegisterTestMachines(registry, builds, 3);
+    registry.SetCapacity(2);
+
+    auto machine1 = registry.Get(1, L".");
+    registry.Get(2, L".");
+    registry.Get(1, L".");
+    registry.Get(3, L".");
+    ASSERT_EQ(3, builds);
+    ASSERT_EQ(2, registry.GetCachedCount());
+
+    // 1 was used more recently than 2, so 2 was evicted
+    ASSERT_EQ(machine1, registry.Get(1, L"."));
+    registry.Get(2, L".");
+    ASSERT_EQ(4, builds);
+}
+
+/**
+ * Tests that an evicted machine is freed, including one whose
+ * pulleys are belted to each other
+ */
+TEST(MachineRegistryTest, EvictionFrees)
+{
+    MachineRegistry registry;
+    registry.Register(1, L"Machine 1", Machine1Factory::Create);
+    registry.Register(2, L"Machine 2", Machine2Factory::Create);
+    registry.SetCapacity(1);
+
+    std::weak_ptr<Machine> machine1 = registry.Get(1, L".");
+    ASSERT_FALSE(machine1.expired());
+
+    std::weak_ptr<Machine> machine2 = registry.Get(2, L".");
+    ASSERT_TRUE(machine1.expired());
+
+    registry.Clear();
+    ASSERT_TRUE(machine2.expired());
+}
+
+/**
+ * Tests building a machine on a worker thread
+ */
+TEST(MachineRegistryTest, Async)
+{
+    MachineRegistry registry;
+    int builds = 0;
+    RegisterTestMachines(registry, builds, 2);
+
+    auto pending = registry.BuildAsync(2, L".");
+    ASSERT_TRUE(pending.valid());
+    ASSERT_TRUE(registry.IsPending(2));
+    ASSERT_FALSE(registry.BuildAsync(3, L".").valid());
+
+    pending.wait();
+    registry.Poll();
+    ASSERT_FALSE(registry.IsPending(2));
+    ASSERT_TRUE(registry.IsCached(2));
+
+    // The machine built in the background is the one handed out
+    ASSERT_EQ(pending.get(), registry.Get(2, L"."));
+    ASSERT_EQ(1, builds);
+
+    // Building and then collecting the machine is one request
+    ASSERT_EQ(0, registry.GetHits());
+    ASSERT_EQ(1, registry.GetMisses());
+
+    // Prewarming a cached machine does nothing
+    registry.Prewarm(2, L".");
+    ASSERT_FALSE(registry.IsPending(2));
+
+    // A machine prewarmed in the background is a hit when it is asked for
+    registry.Prewarm(1, L".");
+    ASSERT_TRUE(registry.IsPending(1));
+    registry.Get(1, L".");
+    ASSERT_EQ(1, registry.GetHits());
+    ASSERT_EQ(1, registry.GetMisses());
+}
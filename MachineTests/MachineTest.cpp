@@ -8,6 +8,10 @@
 
 #include <MachineSystemFactory.h>
 #include <IMachineSystem.h>
+#include <b2_world.h>
+#include <b2_fixture.h>
+#include <Machine.h>
+#include <Body.h>
 
 /**
  * Tests the constructor of machine system factory
@@ -72,4 +76,39 @@ TEST(MachineTest, MachineNumber)
     // Ensure we can go back to machine number 1
     machine->SetMachineNumber(1);
     ASSERT_EQ(1, machine->GetMachineNumber());
-}
\ No newline at end of file
+}
+
+/**
+ * Tests that static bodies share one physics body
+ */
+TEST(MachineTest, MergeStatic)
+{
+    Machine machine;
+    for (int i = 0; i < 3; i++)
+    {
+        auto wall = std::make_shared<Body>();
+        wall->Rectangle(i * 100, 0, 20, 100);
+        machine.AddComponent(wall);
+    }
+
+    auto ball = std::make_shared<Body>();
+    ball->SetInitialPosition(50, 200);
+    ball->Circle(10);
+    ball->SetDynamic();
+    machine.AddComponent(ball);
+
+    // One merged static body and the ball
+    ASSERT_EQ(2, machine.GetWorld()->GetBodyCount());
+
+    int fixtures = 0;
+    for (auto fixture = machine.GetStaticBody()->GetFixtureList(); fixture != nullptr; fixture = fixture->GetNext())
+    {
+        fixtures++;
+    }
+    ASSERT_EQ(3, fixtures);
+
+    machine.SetMergeStatic(false);
+    machine.Reset();
+    ASSERT_EQ(4, machine.GetWorld()->GetBodyCount());
+    ASSERT_EQ(nullptr, machine.GetStaticBody());
+}
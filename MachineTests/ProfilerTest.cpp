@@ -0,0 +1,60 @@
+/**
+ * @file ProfilerTest.cpp
+ * @author djmik
+ */
+
+#include "pch.h"
+#include "gtest/gtest.h"
+
+#include <Profiler.h>
+#include <MachineSystem.h>
+
+/**
+ * Tests that statistics only cover the most recent samples
+ */
+TEST(ProfilerTest, Statistic)
+{
+    Profiler::Statistic statistic;
+    ASSERT_EQ(0, statistic.GetAverage());
+
+    statistic.Add(100);
+    for (size_t i = 0; i < Profiler::Window; i++)
+    {
+        statistic.Add(2);
+    }
+
+    ASSERT_NEAR(2, statistic.GetAverage(), 0.0001);
+    ASSERT_NEAR(2, statistic.GetMax(), 0.0001);
+    ASSERT_EQ(Profiler::Window + 1, statistic.GetCount());
+}
+
+/**
+ * Tests that a profiled machine records its components and physics step
+ */
+TEST(ProfilerTest, Machine)
+{
+    MachineSystem system(L".");
+    system.SetAsynchronous(false);
+    system.SetMachineNumber(1);
+    ASSERT_EQ(nullptr, system.GetProfiler());
+
+    system.SetProfiling(true);
+    system.SetMachineFrame(10);
+
+    auto profiler = system.GetProfiler();
+    ASSERT_NE(nullptr, profiler);
+    ASSERT_EQ(10, profiler->GetUpdate().GetCount());
+    ASSERT_EQ(10, profiler->GetStep().at("step").GetCount());
+    ASSERT_FALSE(profiler->GetUpdateTypes().empty());
+
+    // Each type gets one sample per update however many instances it has
+    for (const auto& [type, statistic] : profiler->GetUpdateTypes())
+    {
+        ASSERT_EQ(10, statistic.GetCount());
+    }
+
+    ASSERT_EQ(profiler->GetInstanceTypes().size(), profiler->GetUpdateInstances().size());
+
+    system.SetProfiling(false);
+    ASSERT_EQ(nullptr, system.GetProfiler());
+}
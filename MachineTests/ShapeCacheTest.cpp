@@ -0,0 +1,79 @@
+/**
+ * @file ShapeCacheTest.cpp
+ * @author djmik
+ */
+
+#include "pch.h"
+#include "gtest/gtest.h"
+#include <b2_polygon_shape.h>
+#include <b2_circle_shape.h>
+
+#include <ShapeCache.h>
+#include <StateRecorder.h>
+#include <Machine1Factory.h>
+#include <Machine2Factory.h>
+#include <Machine.h>
+
+/**
+ * Tests that identical geometry shares one shape
+ */
+TEST(ShapeCacheTest, Shared)
+{
+    ShapeCache::Clear();
+
+    std::vector<wxPoint2DDouble> domino = {
+        wxPoint2DDouble(0, 0), wxPoint2DDouble(5, 0), wxPoint2DDouble(5, 20), wxPoint2DDouble(0, 20)};
+    auto first = ShapeCache::Polygon(domino);
+    auto second = ShapeCache::Polygon(domino);
+    ASSERT_EQ(first, second);
+
+    domino[2].m_y = 21;
+    ASSERT_NE(first, ShapeCache::Polygon(domino));
+
+    ASSERT_EQ(ShapeCache::Circle(12), ShapeCache::Circle(12));
+    ASSERT_NE(ShapeCache::Circle(12), ShapeCache::Circle(15));
+    ASSERT_EQ(4, ShapeCache::GetCount());
+
+    ShapeCache::Clear();
+    ASSERT_EQ(0, ShapeCache::GetCount());
+
+    // Without sharing every request gets its own shape
+    ShapeCache::SetEnabled(false);
+    ASSERT_NE(ShapeCache::Circle(12), ShapeCache::Circle(12));
+    ASSERT_EQ(0, ShapeCache::GetCount());
+    ShapeCache::SetEnabled(true);
+}
+
+/**
+ * Tests that shapes allow for the Box2D skin
+ */
+TEST(ShapeCacheTest, Skin)
+{
+    auto circle = std::static_pointer_cast<const b2CircleShape>(ShapeCache::Circle(10));
+    ASSERT_NEAR(0.095, circle->m_radius, 0.0001);
+
+    auto polygon = std::static_pointer_cast<const b2PolygonShape>(ShapeCache::Polygon({
+        wxPoint2DDouble(0, 0), wxPoint2DDouble(10, 0), wxPoint2DDouble(10, 10), wxPoint2DDouble(0, 10)}));
+    ASSERT_EQ(4, polygon->m_count);
+    ASSERT_NEAR(0.05, polygon->m_centroid.x, 0.0001);
+}
+
+/**
+ * Tests that sharing shapes does not change how machines run
+ */
+TEST(ShapeCacheTest, Trajectories)
+{
+    for (auto create : {Machine1Factory::Create, Machine2Factory::Create})
+    {
+        ShapeCache::SetEnabled(false);
+        StateRecorder unshared;
+        unshared.Record(*create(L"."), 300);
+
+        ShapeCache::SetEnabled(true);
+        StateRecorder shared;
+        shared.Record(*create(L"."), 300);
+
+        auto divergence = unshared.Compare(shared);
+        ASSERT_FALSE(divergence.IsDivergent()) << StateRecorder::Describe(divergence);
+    }
+}
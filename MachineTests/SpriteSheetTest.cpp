@@ -0,0 +1,65 @@
+/**
+ * @file SpriteSheetTest.cpp
+ * @author djmik
+ */
+
+#include "pch.h"
+#include "gtest/gtest.h"
+#include <wx/filename.h>
+
+#include <SpriteSheet.h>
+#include <ImageCache.h>
+
+/**
+ * Tests frame selection over an animation cycle
+ */
+TEST(SpriteSheetTest, FrameAt)
+{
+    ASSERT_EQ(0, SpriteSheet::FrameAt(0, 4));
+    ASSERT_EQ(1, SpriteSheet::FrameAt(0.3, 4));
+    ASSERT_EQ(3, SpriteSheet::FrameAt(0.99, 4));
+    ASSERT_EQ(2, SpriteSheet::FrameAt(7.6, 4));
+
+    // Running backwards
+    ASSERT_EQ(1, SpriteSheet::FrameAt(-0.3, 4));
+    ASSERT_EQ(0, SpriteSheet::FrameAt(0.5, 0));
+}
+
+/**
+ * Tests sheets made from one image per frame and from a single image
+ */
+TEST(SpriteSheetTest, Frames)
+{
+    auto dir = wxFileName::CreateTempFileName(L"sprites");
+    wxRemoveFile(dir);
+    ASSERT_TRUE(wxMkdir(dir));
+
+    std::vector<std::wstring> frames;
+    for (int i = 0; i < 3; i++)
+    {
+        wxImage image(16, 12);
+        auto filename = dir + wxString::Format(L"/frame%d.png", i);
+        image.SaveFile(filename, wxBITMAP_TYPE_PNG);
+        frames.push_back(filename.ToStdWstring());
+    }
+
+    SpriteSheet::Clear();
+    auto sheet = SpriteSheet::Get(frames);
+    ASSERT_TRUE(sheet->IsOk());
+    ASSERT_EQ(3, sheet->GetFrameCount());
+    ASSERT_EQ(wxSize(16, 12), sheet->GetFrameSize());
+
+    // Shared by everything using the same frames
+    ASSERT_EQ(sheet, SpriteSheet::Get(frames));
+
+    auto single = SpriteSheet::Get(frames[0], 4);
+    ASSERT_TRUE(single->IsOk());
+    ASSERT_EQ(4, single->GetFrameCount());
+    ASSERT_EQ(wxSize(4, 12), single->GetFrameSize());
+
+    ASSERT_FALSE(SpriteSheet::Get({frames[0], dir.ToStdWstring() + L"/missing.png"})->IsOk());
+
+    SpriteSheet::Clear();
+    ImageCache::Clear();
+    wxFileName::Rmdir(dir, wxPATH_RMDIR_RECURSIVE);
+}
@@ -0,0 +1,100 @@
+/**
+ * @file StateRecorderTest.cpp
+ * @author djmik
+ */
+
+#include "pch.h"
+#include "gtest/gtest.h"
+#include <wx/filename.h>
+#include <cmath>
+
+#include <StateRecorder.h>
+#include <StateHash.h>
+#include <Machine1Factory.h>
+#include <Machine2Factory.h>
+#include <Machine.h>
+
+/**
+ * Tests that the hash depends on the exact value added
+ */
+TEST(StateRecorderTest, Hash)
+{
+    StateHash a, b, c;
+    a.Add(1.0);
+    b.Add(1.0);
+    c.Add(std::nextafter(1.0, 2.0));
+    ASSERT_EQ(a.Get(), b.Get());
+    ASSERT_NE(a.Get(), c.Get());
+
+    // Zero is zero whatever its sign
+    StateHash zero, negativeZero;
+    zero.Add(0.0);
+    negativeZero.Add(-0.0);
+    ASSERT_EQ(zero.Get(), negativeZero.Get());
+}
+
+/**
+ * Tests that separate runs of a machine are identical
+ */
+TEST(StateRecorderTest, Repeatable)
+{
+    auto machine = Machine1Factory::Create(L".");
+    StateRecorder first;
+    first.Record(*machine, 120);
+    ASSERT_EQ(121, first.GetFrames().size());
+    ASSERT_NE(first.GetFrames().front().hash, first.GetFrames().back().hash);
+
+    // The same machine run again after a reset
+    StateRecorder again;
+    again.Record(*machine, 120);
+    ASSERT_FALSE(first.Compare(again).IsDivergent());
+
+    // A machine built from scratch
+    StateRecorder rebuilt;
+    rebuilt.Record(*Machine1Factory::Create(L"."), 120);
+    ASSERT_FALSE(first.Compare(rebuilt).IsDivergent());
+}
+
+/**
+ * Tests that the first difference is reported
+ */
+TEST(StateRecorderTest, Divergence)
+{
+    StateRecorder machine1;
+    machine1.Record(*Machine1Factory::Create(L"."), 30);
+
+    StateRecorder machine2;
+    machine2.Record(*Machine2Factory::Create(L"."), 30);
+
+    auto divergence = machine1.Compare(machine2);
+    ASSERT_EQ(0, divergence.frame);
+    ASSERT_NE(L"No divergence", StateRecorder::Describe(divergence));
+
+    // A shorter run matches up to where it stops
+    StateRecorder shorter;
+    shorter.Record(*Machine1Factory::Create(L"."), 20);
+    divergence = machine1.Compare(shorter);
+    ASSERT_EQ(21, divergence.frame);
+    ASSERT_EQ(-1, divergence.body);
+}
+
+/**
+ * Tests saving and loading a recording
+ */
+TEST(StateRecorderTest, SaveLoad)
+{
+    StateRecorder recorder;
+    recorder.Record(*Machine1Factory::Create(L"."), 30);
+
+    auto filename = wxFileName::CreateTempFileName(L"state").ToStdWstring();
+    ASSERT_TRUE(recorder.Save(filename));
+
+    StateRecorder loaded;
+    ASSERT_TRUE(loaded.Load(filename));
+    ASSERT_EQ(recorder.GetFrames().size(), loaded.GetFrames().size());
+    ASSERT_FALSE(recorder.Compare(loaded).IsDivergent());
+    wxRemoveFile(filename);
+
+    ASSERT_FALSE(loaded.Load(L"missing.state"));
+    ASSERT_FALSE(loaded.GetError().empty());
+}
@@ -0,0 +1,45 @@
+/**
+ * @file StressFactoryTest.cpp
+ * @author djmik
+ */
+
+#include "pch.h"
+#include "gtest/gtest.h"
+#include <b2_world.h>
+
+#include <StressFactory.h>
+#include <Machine.h>
+
+/**
+ * Tests that parameters are chosen to give the requested size
+ */
+TEST(StressFactoryTest, ForBodies)
+{
+    for (int bodies : {100, 1000, 10000, 100000})
+    {
+        auto parameters = StressFactory::ForBodies(bodies);
+        auto count = StressFactory::BodyCount(parameters);
+        ASSERT_GT(count, bodies * 0.95);
+        ASSERT_LE(count, bodies);
+    }
+}
+
+/**
+ * Tests that a machine has the bodies its parameters describe
+ */
+TEST(StressFactoryTest, Create)
+{
+    StressFactory::Parameters parameters;
+    parameters.dominoRows = 3;
+    parameters.dominoesPerRow = 10;
+    parameters.balls = 7;
+    parameters.chains = 2;
+
+    auto machine = StressFactory::Create(L".", parameters);
+    ASSERT_EQ(StressFactory::BodyCount(parameters), machine->GetWorld()->GetBodyCount());
+
+    // Still the same after a reset
+    machine->Update(1.0 / 30);
+    machine->Reset();
+    ASSERT_EQ(StressFactory::BodyCount(parameters), machine->GetWorld()->GetBodyCount());
+}
@@ -0,0 +1,252 @@
+/**
+ * @file TextureAtlasTest.cpp
+ * @author djmik
+ */
+
+#include "pch.h"
+#include "gtest/gtest.h"
+#include <wx/filename.h>
+#include <wx/dir.h>
+
+#include <TextureAtlas.h>
+#include <ImageCache.h>
+
+/**
+ * Write a solid color test image
+ * @param dir Directory to write to
+ * @param width Image width
+ * @param height Image height
+ * @param red Red component of every pixel
+ * @return Image file name
+ */
+static std::wstring SolidImage(const wxString& dir, int width, int height, unsigned char red)
+{
+    wxImage image(width, height);
+    image.SetRGB(wxRect(0, 0, width, height), red, 0, 0);
+    image.SetAlpha();
+    memset(image.GetAlpha(), 255, width * height);
+
+    auto filename = dir + wxString::Format(L"/solid%d.png", red);
+    image.SaveFile(filename, wxBITMAP_TYPE_PNG);
+    return filename.ToStdWstring();
+}
+
+/**
+ * Tests that packed images do not overlap and keep their pixels
+ */
+TEST(TextureAtlasTest, Pack)
+{
+    auto dir = wxFileName::CreateTempFileName(L"atlas");
+    wxRemoveFile(dir);
+    ASSERT_TRUE(wxMkdir(dir));
+
+    TextureAtlas::Clear();
+    TextureAtlas::SetPageSize(128);
+    ImageCache::SetMaxLevels(1);
+
+    auto a = SolidImage(dir, 60, 40, 10);
+    auto b = SolidImage(dir, 60, 20, 20);
+    auto c = SolidImage(dir, 100, 100, 30);
+    auto big = SolidImage(dir, 200, 10, 40);
+    TextureAtlas::Add({a, b, c, big, a, L"missing.png"});
+
+    TextureAtlas::Region ra, rb, rc, rbig;
+    ASSERT_TRUE(TextureAtlas::Find(a, ra));
+    ASSERT_TRUE(TextureAtlas::Find(b, rb));
+    ASSERT_TRUE(TextureAtlas::Find(c, rc));
+
+    // Too wide for a page, so drawn on its own
+    ASSERT_FALSE(TextureAtlas::Find(big, rbig));
+
+    // The tallest image fills the first page, the others share a second
+    ASSERT_EQ(2, TextureAtlas::GetPageCount());
+    ASSERT_EQ(0, rc.page);
+    ASSERT_EQ(1, ra.page);
+    ASSERT_EQ(1, rb.page);
+    ASSERT_FALSE(ra.rect.Intersects(rb.rect));
+    ASSERT_EQ(wxSize(60, 40), ra.rect.GetSize());
+
+    // Page pixels can be rebuilt after the cached images are released
+    ImageCache::Clear();
+    auto page = TextureAtlas::GetPageImage(1);
+    ASSERT_EQ(10, page.GetRed(ra.rect.x, ra.rect.y));
+    ASSERT_EQ(20, page.GetRed(rb.rect.GetRight(), rb.rect.GetBottom()));
+
+    // Edges are extended into the padding
+    ASSERT_EQ(10, page.GetRed(ra.rect.x - 1, ra.rect.y - 1));
+    ASSERT_EQ(255, page.GetAlpha(ra.rect.x - 1, ra.rect.y));
+
+    TextureAtlas::Clear();
+    TextureAtlas::SetPageSize(2048);
+    ImageCache::SetMaxLevels(4);
+    ImageCache::Clear();
+    wxDir::Remove(dir, wxPATH_RMDIR_RECURSIVE);
+}
+
+/**
+ * Tests that pages released once drawn are rebuilt when needed again
+ */
+TEST(TextureAtlasTest, Release)
+{
+    auto dir = wxFileName::CreateTempFileName(L"release");
+    wxRemoveFile(dir);
+    ASSERT_TRUE(wxMkdir(dir));
+
+    TextureAtlas::Clear();
+    ImageCache::Clear();
+    auto policy = ImageCache::GetPolicy();
+    ImageCache::SetPolicy(ImageCache::Policy::Release);
+
+    auto first = SolidImage(dir, 30, 30, 80);
+    TextureAtlas::Add({first});
+
+    wxImage target(100, 100);
+    std::shared_ptr<wxGraphicsContext> graphics(wxGraphicsContext::Create(target));
+    ASSERT_FALSE(TextureAtlas::GetBitmap(graphics, first, 0).IsNull());
+    ASSERT_EQ(0, TextureAtlas::GetMemory());
+
+    // Adding to the released page brings back what was already on it
+    ImageCache::Clear();
+    auto second = SolidImage(dir, 20, 20, 90);
+    TextureAtlas::Add({second});
+
+    TextureAtlas::Region region;
+    ASSERT_TRUE(TextureAtlas::Find(first, region));
+    auto page = TextureAtlas::GetPageImage(region.page);
+    ASSERT_EQ(80, page.GetRed(region.rect.x, region.rect.y));
+
+    graphics.reset();
+    ImageCache::SetPolicy(policy);
+    TextureAtlas::Clear();
+    ImageCache::Clear();
+    wxDir::Remove(dir, wxPATH_RMDIR_RECURSIVE);
+}
+
+/**
+ * Tests that downscaled levels are made and packed
+ */
+TEST(TextureAtlasTest, Levels)
+{
+    auto dir = wxFileName::CreateTempFileName(L"levels");
+    wxRemoveFile(dir);
+    ASSERT_TRUE(wxMkdir(dir));
+
+    // Levels stop before either side drops below 8 pixels
+    ASSERT_EQ(3, ImageCache::GetLevelCount(wxSize(64, 32)));
+    ASSERT_EQ(1, ImageCache::GetLevelCount(wxSize(100, 10)));
+    ASSERT_EQ(4, ImageCache::GetLevelCount(wxSize(1024, 1024)));
+
+    TextureAtlas::Clear();
+    auto file = SolidImage(dir, 64, 32, 70);
+    TextureAtlas::Add({file});
+
+    auto level2 = ImageCache::LoadLevel(file, 2);
+    ASSERT_NE(nullptr, level2);
+    ASSERT_EQ(wxSize(16, 8), level2->GetSize());
+    ASSERT_EQ(70, level2->GetRed(5, 5));
+    ASSERT_EQ(nullptr, ImageCache::LoadLevel(file, 3));
+
+    TextureAtlas::Region region;
+    ASSERT_TRUE(TextureAtlas::Find(file, region, 1));
+    ASSERT_EQ(wxSize(32, 16), region.rect.GetSize());
+    ASSERT_FALSE(TextureAtlas::Find(file, region, 3));
+
+    TextureAtlas::Clear();
+    ImageCache::Clear();
+    wxDir::Remove(dir, wxPATH_RMDIR_RECURSIVE);
+}
+
+/**
+ * Tests that cached images nothing uses are released
+ */
+TEST(TextureAtlasTest, Trim)
+{
+    auto dir = wxFileName::CreateTempFileName(L"trim");
+    wxRemoveFile(dir);
+    ASSERT_TRUE(wxMkdir(dir));
+
+    ImageCache::Clear();
+    auto used = ImageCache::Load(SolidImage(dir, 10, 10, 50));
+    ImageCache::Load(SolidImage(dir, 20, 10, 60));
+    ASSERT_EQ(10 * 10 * 4 + 20 * 10 * 4, ImageCache::GetMemory());
+
+    ASSERT_EQ(20 * 10 * 4, ImageCache::Trim());
+    ASSERT_EQ(1, ImageCache::GetCount());
+
+    ImageCache::Clear();
+    wxDir::Remove(dir, wxPATH_RMDIR_RECURSIVE);
+}
+
+/**
+ * Tests that a mask clears exactly the pixels outside the polygon
+ */
+TEST(TextureAtlasTest, Mask)
+{
+    wxImage image(10, 10);
+    image.SetAlpha();
+    memset(image.GetAlpha(), 255, 100);
+
+    // Triangle covering the lower left half
+    TextureAtlas::ApplyMask(image, {wxPoint2DDouble(0, 0), wxPoint2DDouble(1, 1), wxPoint2DDouble(0, 1)});
+    for (int y = 0; y < 10; y++)
+    {
+        for (int x = 0; x < 10; x++)
+        {
+            // Pixels on the diagonal are cut through their center
+            if (x < y)
+            {
+                ASSERT_EQ(255, image.GetAlpha(x, y));
+            }
+            else if (x > y)
+            {
+                ASSERT_EQ(0, image.GetAlpha(x, y));
+            }
+        }
+    }
+
+    // A mask covering the whole image leaves it alone
+    wxImage full(8, 8);
+    full.SetAlpha();
+    memset(full.GetAlpha(), 200, 64);
+    TextureAtlas::ApplyMask(full, {wxPoint2DDouble(0, 0), wxPoint2DDouble(1, 0),
+                                   wxPoint2DDouble(1, 1), wxPoint2DDouble(0, 1)});
+    for (int i = 0; i < 64; i++)
+    {
+        ASSERT_EQ(200, full.GetAlpha()[i]);
+    }
+}
+
+/**
+ * Tests that masked bitmaps are shared by shape and freed by Trim
+ */
+TEST(TextureAtlasTest, MaskedTrim)
+{
+    auto dir = wxFileName::CreateTempFileName(L"masked");
+    wxRemoveFile(dir);
+    ASSERT_TRUE(wxMkdir(dir));
+
+    TextureAtlas::Clear();
+    auto file = SolidImage(dir, 16, 16, 100);
+
+    wxImage target(100, 100);
+    std::shared_ptr<wxGraphicsContext> graphics(wxGraphicsContext::Create(target));
+    std::vector<wxPoint2DDouble> triangle = {wxPoint2DDouble(0, 0), wxPoint2DDouble(1, 1), wxPoint2DDouble(0, 1)};
+    std::vector<wxPoint2DDouble> diamond = {wxPoint2DDouble(0.5, 0), wxPoint2DDouble(1, 0.5),
+                                            wxPoint2DDouble(0.5, 1), wxPoint2DDouble(0, 0.5)};
+
+    auto bitmap = TextureAtlas::GetMaskedBitmap(graphics, file, 0, triangle);
+    ASSERT_FALSE(bitmap.IsNull());
+    TextureAtlas::GetMaskedBitmap(graphics, file, 0, triangle);
+    TextureAtlas::GetMaskedBitmap(graphics, file, 0, diamond);
+    ASSERT_EQ(2, TextureAtlas::GetMaskedCount());
+
+    // The bitmap already handed out stays usable
+    ASSERT_EQ(2, TextureAtlas::Trim());
+    ASSERT_EQ(0, TextureAtlas::GetMaskedCount());
+    ASSERT_FALSE(bitmap.IsNull());
+
+    graphics.reset();
+    TextureAtlas::Clear();
+    ImageCache::Clear();
+    wxDir::Remove(dir, wxPATH_RMDIR_RECURSIVE);
+}
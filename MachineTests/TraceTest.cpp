@@ -0,0 +1,57 @@
+/**
+ * @file TraceTest.cpp
+ * @author djmik
+ */
+
+#include "pch.h"
+#include "gtest/gtest.h"
+#include <thread>
+
+#include <Trace.h>
+
+/**
+ * Tests recording events from several threads and exporting them
+ */
+TEST(TraceTest, Record)
+{
+    {
+        // Nothing is recorded before the trace starts
+        TRACE_SCOPE("before", "test");
+    }
+
+    Trace::Start(4);
+    {
+        TRACE_SCOPE("outer", "test");
+        TRACE_SCOPE("inner", "test", typeid(std::string).name());
+    }
+
+    std::thread worker([]() {
+        for (int i = 0; i < 6; i++)
+        {
+            TRACE_SCOPE("worker", "test");
+        }
+    });
+    worker.join();
+    Trace::Stop();
+
+    {
+        TRACE_SCOPE("after", "test");
+    }
+
+    // The worker's buffer only holds four events
+    ASSERT_EQ(6, Trace::GetCount());
+    ASSERT_EQ(2, Trace::GetDropped());
+
+    auto json = Trace::ToJson();
+    ASSERT_NE(std::string::npos, json.find("\"traceEvents\""));
+    ASSERT_NE(std::string::npos, json.find("\"name\":\"outer\""));
+    ASSERT_NE(std::string::npos, json.find("\"name\":\"inner\""));
+    ASSERT_NE(std::string::npos, json.find("\"name\":\"worker\""));
+    ASSERT_EQ(std::string::npos, json.find("before"));
+    ASSERT_EQ(std::string::npos, json.find("after"));
+
+    // Starting again discards the events
+    Trace::Start();
+    Trace::Stop();
+    ASSERT_EQ(0, Trace::GetCount());
+}
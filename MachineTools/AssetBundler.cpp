@@ -0,0 +1,60 @@
+/**
+ * @file AssetBundler.cpp
+ * @author djmik
+ *
+ * Command line tool that packs every image in a directory
+ * into a single asset bundle file.
+ *
+ * Usage: AssetBundler [--raw] imagesDir images.bundle
+ *
+ * With --raw the images are stored already decoded, which makes
+ * the bundle larger but loading it needs no decoding at all.
+ */
+
+#include "pch.h"
+#include <wx/init.h>
+#include <iostream>
+#include <AssetBundle.h>
+
+/**
+ * Main entry point
+ * @param argc Argument count
+ * @param argv Arguments
+ * @return Zero if successful
+ */
+int main(int argc, char* argv[])
+{
+    wxInitializer initializer;
+    if (!initializer.IsOk())
+    {
+        std::cerr << "Unable to initialize wxWidgets" << std::endl;
+        return 1;
+    }
+
+    wxInitAllImageHandlers();
+
+    auto format = AssetBundle::Format::Encoded;
+    int first = 1;
+    if (argc > 1 && std::string(argv[1]) == "--raw")
+    {
+        format = AssetBundle::Format::Raw;
+        first++;
+    }
+
+    if (argc - first != 2)
+    {
+        std::cerr << "Usage: AssetBundler [--raw] imagesDir images.bundle" << std::endl;
+        return 1;
+    }
+
+    AssetBundle bundle;
+    auto filename = wxString(argv[first + 1]).ToStdWstring();
+    if (!bundle.Save(wxString(argv[first]).ToStdWstring(), filename, format) || !bundle.Open(filename))
+    {
+        std::wcerr << bundle.GetError() << std::endl;
+        return 1;
+    }
+
+    std::cout << argv[first + 1] << ": " << bundle.GetCount() << " images" << std::endl;
+    return 0;
+}
@@ -0,0 +1,58 @@
+/**
+ * @file MachineCompiler.cpp
+ * @author djmik
+ *
+ * Command line tool that compiles a machine description
+ * XML file into the binary machine format.
+ *
+ * Usage: MachineCompiler machine.xml machine.bin
+ */
+
+#include "pch.h"
+#include <wx/init.h>
+#include <iostream>
+#include <MachineLoader.h>
+#include <MachineBinary.h>
+#include <MachineDescription.h>
+
+/**
+ * Main entry point
+ * @param argc Argument count
+ * @param argv Arguments
+ * @return Zero if successful
+ */
+int main(int argc, char* argv[])
+{
+    wxInitializer initializer;
+    if (!initializer.IsOk())
+    {
+        std::cerr << "Unable to initialize wxWidgets" << std::endl;
+        return 1;
+    }
+
+    if (argc != 3)
+    {
+        std::cerr << "Usage: MachineCompiler machine.xml machine.bin" << std::endl;
+        return 1;
+    }
+
+    MachineLoader loader;
+    auto description = loader.Parse(wxString(argv[1]).ToStdWstring());
+    if (description == nullptr)
+    {
+        std::wcerr << loader.GetError() << std::endl;
+        return 1;
+    }
+
+    MachineBinary binary;
+    if (!binary.Save(*description, wxString(argv[2]).ToStdWstring()))
+    {
+        std::wcerr << binary.GetError() << std::endl;
+        return 1;
+    }
+
+    std::cout << argv[1] << ": " << description->GetElements().size() << " elements, "
+              << description->GetAssets().size() << " images, parsed in "
+              << loader.GetParseTime() << "ms" << std::endl;
+    return 0;
+}